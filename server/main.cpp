@@ -1,6 +1,9 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <stdexcept>
 
 #include <stdio.h>
@@ -11,6 +14,7 @@
 #include "factories.h"
 #include "classifier.h"
 #include "dataset_wrapper.h"
+#include "thread_pool.h"
 
 #define USE_LOG  1
 #define LOG_FILE "main.log"
@@ -31,6 +35,7 @@ struct Args {
   std::string learn_;
   std::string test_;
   std::string pocket_id_;
+  int threads_;   // number of worker threads of the global pool (0 for all cores)
 };
 
 class Log {
@@ -55,7 +60,8 @@ private:
 
 sh_ptr<DataSet> LoadDataSet(const string& dataFileName) {
     sh_ptr<DataSet> dataSet(new DataSet());
-    if (!dataSet->Load(dataFileName)) {
+    // parsed on the global pool
+    if (!dataSet->Load(dataFileName, UnknownFormat, 0)) {
         LOG("Error: dataset '%s' was not loaded correctly"
           , dataSet->GetName().c_str());
         return dataSet;
@@ -188,6 +194,13 @@ int main(int argc, const char* argv[]) {
   LOG("Learn Indexes: %s", args.learn_.c_str());
   LOG("Test Indexes : %s", args.test_.c_str());
   LOG("Pocket Id    : %s", args.pocket_id_.c_str());
+  LOG("Threads      : %d", args.threads_);
+
+  ThreadPool::SetGlobalThreadCount(args.threads_);
+  if (args.threads_ == 1) {
+    // no threads are started, so reference counting can skip atomic operations
+    set_single_threaded(true);
+  }
   
   string testTargetsFileName = GetTargetsFileName(args.test_);
   string learningTargetsFileName = GetTargetsFileName(args.learn_);
@@ -285,7 +298,8 @@ int main(int argc, const char* argv[]) {
   return EXIT_SUCCESS;
 }
 
-Args::Args(int argc, const char* argv[]) {
+Args::Args(int argc, const char* argv[])
+  : threads_(1) {
   if (argc > 1) { alg_name_.assign(argv[1]); }
   if (argc > 2) { alg_author_.assign(argv[2]); }
   if (argc > 3) { alg_params_.assign(argv[3]); }
@@ -293,6 +307,7 @@ Args::Args(int argc, const char* argv[]) {
   if (argc > 5) { learn_.assign(argv[5]); }
   if (argc > 6) { test_.assign(argv[6]); }
   if (argc > 7) { pocket_id_.assign(argv[7]); }
+  if (argc > 8) { threads_ = atoi(argv[8]); }
 }
 
 Log::Log()
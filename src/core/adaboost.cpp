@@ -0,0 +1,133 @@
+#include "adaboost.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "dataset_wrapper.h"
+
+using std::vector;
+
+REGISTER_CLASSIFIER(mll::AdaBoost, "AdaBoost", "MLL", "AdaBoost ensemble of weak learners");
+
+namespace mll {
+
+namespace {
+
+//! Classifies the objects of the wrapper and gets the predicted targets in the original order of objects
+void Predict(const IClassifier& classifier, DataSetWrapper* wrapper, vector<int>* predictions) {
+    for (int i = 0; i < wrapper->GetObjectCount(); ++i) {
+        wrapper->SetTarget(i, Refuse);
+    }
+    classifier.Classify(wrapper);
+    wrapper->ResetObjectIndexes();
+    wrapper->GetTargets(0, wrapper->GetObjectCount(), &predictions->at(0));
+}
+
+//! Normalizes the weights so that their sum equals to 1.0 (equal weights if the sum is zero)
+void NormalizeWeights(vector<double>* weights) {
+    double weightSum = 0;
+    for (int i = 0; i < static_cast<int>(weights->size()); ++i) {
+        weightSum += weights->at(i);
+    }
+    for (int i = 0; i < static_cast<int>(weights->size()); ++i) {
+        weights->at(i) = weightSum > 0 ? weights->at(i) / weightSum : 1.0 / weights->size();
+    }
+}
+
+} // namespace
+
+void AdaBoost::Learn(IDataSet* data) {
+    classifiers_.clear();
+    votes_.clear();
+    int objectCount = data->GetObjectCount();
+    int classCount = data->GetClassCount();
+    if (objectCount == 0) {
+        return;
+    }
+    sh_ptr<IClassifier> learner = weakLearner_.get() != NULL
+        ? weakLearner_->Clone()
+        : ClassifierFactory::Instance().Create(weakLearnerName_);
+    if (learner.get() == NULL) {
+        throw std::logic_error("Weak learner is not registered");
+    }
+    vector<int> targets(objectCount);
+    vector<double> weights(objectCount);
+    vector<int> predictions(objectCount);
+    data->GetTargets(0, objectCount, &targets[0]);
+    data->GetWeights(0, objectCount, &weights[0]);
+    NormalizeWeights(&weights);
+    // all rounds change only the weights of one wrapper, the features and
+    // the orders of objects cached by the data are shared by the rounds
+    DataSetWrapper weighted(data);
+    DataSetWrapper predicted(data);
+    for (int round = 0; round < roundCount_; ++round) {
+        for (int i = 0; i < objectCount; ++i) {
+            weighted.SetWeight(i, weights[i]);
+        }
+        learner->Learn(&weighted);
+        Predict(*learner, &predicted, &predictions);
+        double error = 0;
+        for (int i = 0; i < objectCount; ++i) {
+            if (predictions[i] != targets[i]) {
+                error += weights[i];
+            }
+        }
+        if (error >= 1.0 - 1.0 / classCount) {
+            // not better than random guessing, the first learner is kept anyway
+            if (classifiers_.empty()) {
+                classifiers_.push_back(learner->Clone());
+                votes_.push_back(1.0);
+            }
+            break;
+        }
+        if (error <= 0) {
+            // the learner makes no errors, so it outvotes all the others
+            classifiers_.assign(1, learner->Clone());
+            votes_.assign(1, 1.0);
+            break;
+        }
+        double vote = std::log((1.0 - error) / error) + std::log(classCount - 1.0);
+        classifiers_.push_back(learner->Clone());
+        votes_.push_back(vote);
+        double factor = std::exp(vote);
+        for (int i = 0; i < objectCount; ++i) {
+            if (predictions[i] != targets[i]) {
+                weights[i] *= factor;
+            }
+        }
+        NormalizeWeights(&weights);
+    }
+}
+
+void AdaBoost::Classify(IDataSet* data) const {
+    int objectCount = data->GetObjectCount();
+    int classCount = data->GetClassCount();
+    if (objectCount == 0) {
+        return;
+    }
+    // votes of the classifiers for the classes of the objects: scores[object * classCount + class]
+    vector<double> scores(objectCount * classCount);
+    vector<int> predictions(objectCount);
+    DataSetWrapper predicted(data);
+    for (int k = 0; k < GetClassifierCount(); ++k) {
+        Predict(*classifiers_[k], &predicted, &predictions);
+        for (int i = 0; i < objectCount; ++i) {
+            if (predictions[i] != Refuse) {
+                scores[i * classCount + predictions[i]] += votes_[k];
+            }
+        }
+    }
+    for (int i = 0; i < objectCount; ++i) {
+        int target = Refuse;
+        double maxScore = 0;
+        for (int label = 0; label < classCount; ++label) {
+            if (scores[i * classCount + label] > maxScore) {
+                maxScore = scores[i * classCount + label];
+                target = label;
+            }
+        }
+        data->SetTarget(i, target);
+    }
+}
+
+} // namespace mll
@@ -0,0 +1,84 @@
+#ifndef ADABOOST_H_
+#define ADABOOST_H_
+
+#include <string>
+#include <vector>
+
+#include "classifier.h"
+#include "factories.h"
+
+namespace mll {
+
+//! AdaBoost ensemble of weak learners created by the classifier factory
+/*! Multiclass boosting (SAMME): every round a weak learner is learned on the
+    reweighted data and gets a vote by its weighted error, then the weights of
+    the objects it misclassified are increased. Boosting stops when the error
+    is not better than random guessing or when a learner makes no errors.
+    All rounds learn one weak learner on one wrapper of the data which changes
+    only weights, so features are neither copied nor sorted again: the orders
+    of objects cached by the data are shared by all rounds.
+*/
+class AdaBoost: public Classifier<AdaBoost> {
+	DECLARE_REGISTRATION();
+public:
+    //! Default initialization
+    AdaBoost()
+        : weakLearnerName_("DecisionStump"),
+          roundCount_(100) {
+        AddParameter("l", weakLearnerName_, &AdaBoost::GetWeakLearnerName, &AdaBoost::SetWeakLearnerName,
+                     "Name of the weak learner in the classifier factory");
+        AddParameter("r", roundCount_, &AdaBoost::GetRoundCount, &AdaBoost::SetRoundCount,
+                     "Number of boosting rounds");
+    }
+
+    //! Learn data
+    virtual void Learn(IDataSet* data);
+    //! Classify data
+    virtual void Classify(IDataSet* data) const;
+
+    //! Name of the weak learner in the classifier factory
+    const std::string& GetWeakLearnerName() const {
+        return weakLearnerName_;
+    }
+
+    //! Sets the weak learner by its name in the classifier factory (with default parameters)
+    void SetWeakLearnerName(const std::string& weakLearnerName) {
+        if (ClassifierFactory::Instance().Contains(weakLearnerName)) {
+            weakLearnerName_ = weakLearnerName;
+            weakLearner_ = sh_ptr<IClassifier>();
+        }
+    }
+
+    //! Sets the weak learner, its copies are learned in the rounds
+    void SetWeakLearner(const IClassifier& weakLearner) {
+        weakLearner_ = weakLearner.Clone();
+    }
+
+    //! Number of boosting rounds
+    int GetRoundCount() const {
+        return roundCount_;
+    }
+
+    //! Sets number of boosting rounds
+    void SetRoundCount(int roundCount) {
+        if (roundCount >= 1) {
+            roundCount_ = roundCount;
+        }
+    }
+
+    //! Number of learned weak classifiers (less than the number of rounds if boosting stopped)
+    int GetClassifierCount() const {
+        return static_cast<int>(classifiers_.size());
+    }
+
+private:
+    std::string weakLearnerName_;                       //!< Name of the weak learner in the factory
+    sh_ptr<IClassifier> weakLearner_;                   //!< Weak learner set explicitly (NULL to create by name)
+    int roundCount_;                                    //!< Number of boosting rounds
+    std::vector< sh_ptr<IClassifier> > classifiers_;    //!< Learned weak classifiers
+    std::vector<double> votes_;                         //!< Votes of the weak classifiers
+};
+
+} // namespace mll
+
+#endif // ADABOOST_H_
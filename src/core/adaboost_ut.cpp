@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "adaboost.h"
+#include "dataset.h"
+
+using namespace mll;
+
+class AdaBoostTest : public testing::Test {
+protected:
+	//! Learns the classifier and returns the number of misclassified objects of the data
+	static int GetErrors(IClassifier* classifier, DataSet* dataSet) {
+		classifier->Learn(dataSet);
+		DataSetWrapper results(dataSet);
+		classifier->Classify(&results);
+		int errors = 0;
+		for (int i = 0; i < dataSet->GetObjectCount(); i++) {
+			if (results.GetTarget(i) != dataSet->GetTarget(i)) {
+				errors++;
+			}
+		}
+		return errors;
+	}
+};
+
+TEST_F(AdaBoostTest, BoostingTest)
+{
+	const int SIDE = 20;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(SIDE * SIDE, 2);
+	for (int i = 0; i < SIDE * SIDE; i++) {
+		// the classes are separated by the diagonal, one threshold can't do it
+		dataSet.SetFeature(i, 0, i % SIDE);
+		dataSet.SetFeature(i, 1, i / SIDE);
+		dataSet.SetTarget(i, i % SIDE + i / SIDE >= SIDE);
+		dataSet.SetWeight(i, 1.0);
+	}
+	sh_ptr< const std::vector<int> > order = dataSet.GetSortedObjectIndexes(0);
+
+	sh_ptr<IClassifier> stump = ClassifierFactory::Instance().Create("DecisionStump");
+	sh_ptr<IClassifier> boosting = ClassifierFactory::Instance().Create("AdaBoost");
+	ASSERT_TRUE(boosting.get() != NULL);
+	ASSERT_TRUE(boosting->SetParameter("r", "200"));
+	ASSERT_LT(GetErrors(boosting.get(), &dataSet), GetErrors(stump.get(), &dataSet) / 2);
+	ASSERT_EQ(200, dynamic_cast<AdaBoost&>(*boosting).GetClassifierCount());
+
+	// the data is neither changed nor sorted again
+	ASSERT_EQ(order.get(), dataSet.GetSortedObjectIndexes(0).get());
+	for (int i = 0; i < SIDE * SIDE; i++) {
+		ASSERT_EQ(1.0, dataSet.GetWeight(i));
+	}
+
+	// the exact search by all values gives the same ensemble as the search by bins
+	sh_ptr<IClassifier> exactStump = ClassifierFactory::Instance().Create("DecisionStump");
+	ASSERT_TRUE(exactStump->SetParameter("b", "0"));
+	AdaBoost exactBoosting;
+	exactBoosting.SetRoundCount(200);
+	exactBoosting.SetWeakLearner(*exactStump);
+	ASSERT_EQ(GetErrors(boosting.get(), &dataSet), GetErrors(&exactBoosting, &dataSet));
+}
+
+TEST_F(AdaBoostTest, SeparableTest)
+{
+	const int OBJECTS = 100;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	classes.push_back("2");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 1);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, i % 2);
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, 1.0);
+	}
+
+	// one learner without errors stops boosting
+	AdaBoost boosting;
+	ASSERT_FALSE(boosting.SetParameter("unknown", "1"));
+	ASSERT_TRUE(boosting.SetParameter("l", "Unregistered"));
+	ASSERT_EQ("DecisionStump", boosting.GetParameter("l"));
+	ASSERT_EQ(0, GetErrors(&boosting, &dataSet));
+	ASSERT_EQ(1, boosting.GetClassifierCount());
+}
@@ -0,0 +1,107 @@
+#ifndef ALIGNED_ALLOCATOR_H_
+#define ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace mll {
+
+//! Default alignment of data buffers (cache line size)
+const size_t DefaultAlignment = 64;
+
+//! Allocates size bytes aligned by the alignment (power of two)
+inline void* AlignedMalloc(size_t size, size_t alignment = DefaultAlignment) {
+    if (size == 0) {
+        size = alignment;
+    }
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size, alignment);
+#else
+    void* ptr = NULL;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        ptr = NULL;
+    }
+#endif
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+//! Frees memory allocated by AlignedMalloc
+inline void AlignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+//! STL allocator which places all the elements in aligned memory blocks
+template<typename T, size_t Alignment = DefaultAlignment>
+class AlignedAllocator {
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+        typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() {
+    }
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) {
+    }
+
+    pointer address(reference value) const {
+        return &value;
+    }
+
+    const_pointer address(const_reference value) const {
+        return &value;
+    }
+
+    pointer allocate(size_type count, const void* /*hint*/ = 0) {
+        return static_cast<pointer>(AlignedMalloc(count * sizeof(T), Alignment));
+    }
+
+    void deallocate(pointer ptr, size_type /*count*/) {
+        AlignedFree(ptr);
+    }
+
+    size_type max_size() const {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    void construct(pointer ptr, const T& value) {
+        new (ptr) T(value);
+    }
+
+    void destroy(pointer ptr) {
+        ptr->~T();
+    }
+
+    bool operator==(const AlignedAllocator&) const {
+        return true;
+    }
+
+    bool operator!=(const AlignedAllocator&) const {
+        return false;
+    }
+};
+
+} // namespace mll
+
+#endif // ALIGNED_ALLOCATOR_H_
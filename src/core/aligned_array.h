@@ -0,0 +1,182 @@
+#ifndef ALIGNED_ARRAY_H_
+#define ALIGNED_ARRAY_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "aligned_allocator.h"
+
+namespace mll {
+
+//! Contiguous array in aligned memory.
+/*! The array either owns its elements or refers to external read-only
+    memory (e.g. a memory-mapped file). External elements are copied to
+    own memory on the first modification.
+*/
+template<typename T>
+class AlignedArray {
+public:
+    //! Creates empty array
+    AlignedArray()
+        : data_(NULL),
+          size_(0),
+          external_(false) {
+    }
+
+    //! Creates array of the given size filled with the value
+    explicit AlignedArray(int size, const T& value = T())
+        : values_(size, value),
+          external_(false) {
+        Update();
+    }
+
+    //! Copy-constructor
+    AlignedArray(const AlignedArray& array)
+        : values_(array.values_),
+          data_(array.data_),
+          size_(array.size_),
+          external_(array.external_) {
+        if (!external_) {
+            Update();
+        }
+    }
+
+    //! Assignment operator
+    AlignedArray& operator=(const AlignedArray& array) {
+        if (this != &array) {
+            values_ = array.values_;
+            data_ = array.data_;
+            size_ = array.size_;
+            external_ = array.external_;
+            if (!external_) {
+                Update();
+            }
+        }
+        return *this;
+    }
+
+    //! Number of elements
+    int GetSize() const {
+        return size_;
+    }
+
+    //! Pointer to the first element (elements are contiguous)
+    const T* GetData() const {
+        return data_;
+    }
+
+    //! Pointer to the first element (elements are contiguous)
+    T* GetData() {
+        Detach();
+        return values_.empty() ? NULL : &values_[0];
+    }
+
+    //! Gets the element with the index
+    const T& Get(int index) const {
+        return data_[index];
+    }
+
+    //! Sets the element with the index
+    void Set(int index, const T& value) {
+        Detach();
+        values_[index] = value;
+    }
+
+    //! Appends one element to the end
+    void PushBack(const T& value) {
+        Detach();
+        values_.push_back(value);
+        Update();
+    }
+
+    //! Appends count elements to the end
+    void Append(const T* values, int count) {
+        Detach();
+        values_.insert(values_.end(), values, values + count);
+        Update();
+    }
+
+    //! Resizes array filling new elements with the value
+    void Resize(int size, const T& value = T()) {
+        Detach();
+        values_.resize(size, value);
+        Update();
+    }
+
+    //! Reserves memory for the number of elements
+    void Reserve(int size) {
+        Detach();
+        values_.reserve(size);
+        Update();
+    }
+
+    //! Swaps two elements
+    void Swap(int index1, int index2) {
+        Detach();
+        std::swap(values_[index1], values_[index2]);
+    }
+
+    //! Moves element indexes[i] to position i for all i (indexes must be a permutation)
+    void Permute(const int* indexes) {
+        std::vector<T, AlignedAllocator<T> > values(size_);
+        for (int i = 0; i < size_; ++i) {
+            values[i] = data_[indexes[i]];
+        }
+        values_.swap(values);
+        external_ = false;
+        Update();
+    }
+
+    //! Swaps contents with other array (no elements are copied)
+    void Swap(AlignedArray& other) {
+        values_.swap(other.values_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(external_, other.external_);
+    }
+
+    //! Removes all elements
+    void Clear() {
+        values_.clear();
+        external_ = false;
+        Update();
+    }
+
+    //! Refers to external memory which must outlive the array
+    void SetExternal(const T* data, int size) {
+        values_.clear();
+        data_ = data;
+        size_ = size;
+        external_ = true;
+    }
+
+    //! Returns true if the array refers to external memory
+    bool IsExternal() const {
+        return external_;
+    }
+
+private:
+    //! Copies external elements to own memory
+    void Detach() {
+        if (external_) {
+            values_.assign(data_, data_ + size_);
+            external_ = false;
+            Update();
+        }
+    }
+
+    //! Updates pointer to own elements
+    void Update() {
+        data_ = values_.empty() ? NULL : &values_[0];
+        size_ = values_.size();
+    }
+
+    std::vector<T, AlignedAllocator<T> > values_;  //!< Own elements
+    const T* data_;                                 //!< Current elements
+    int size_;                                      //!< Number of elements
+    bool external_;                                 //!< If elements are external
+};
+
+} // namespace mll
+
+#endif // ALIGNED_ARRAY_H_
@@ -0,0 +1,420 @@
+#include "arff_parser.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "data.h"
+#include "thread_pool.h"
+#include "util.h"
+
+using std::string;
+using std::vector;
+
+namespace mll {
+
+namespace {
+
+inline bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+//! Splits a line into tokens in place
+class LineTokenizer {
+public:
+    LineTokenizer(const char* begin, const char* end)
+        : position_(begin),
+          end_(end),
+          tokenBegin_(begin),
+          tokenEnd_(begin),
+          braces_(false) {
+        SkipWhiteSpaces();
+    }
+
+    //! Current character ('\0' at the end of the line)
+    char Peek() const {
+        return position_ < end_ ? *position_ : '\0';
+    }
+
+    //! Makes braces delimiters (for nominal values lists)
+    void SetBraces(bool braces) {
+        braces_ = braces;
+    }
+
+    const char* GetTokenBegin() const {
+        return tokenBegin_;
+    }
+
+    const char* GetTokenEnd() const {
+        return tokenEnd_;
+    }
+
+    string GetToken() const {
+        return string(tokenBegin_, tokenEnd_);
+    }
+
+    //! Case-insensitive comparison of the token with the lower case value
+    bool TokenEquals(const char* value) const {
+        const char* position = tokenBegin_;
+        for (; position < tokenEnd_ && *value != '\0'; ++position, ++value) {
+            if (tolower(*position) != *value) {
+                return false;
+            }
+        }
+        return position == tokenEnd_ && *value == '\0';
+    }
+
+    //! Reads the next token, returns false at the end of the line
+    bool ReadNext() {
+        SkipWhiteSpaces();
+        if (position_ == end_) {
+            return false;
+        }
+        if (*position_ == '"') {
+            tokenBegin_ = ++position_;
+            while (position_ < end_ && *position_ != '"') {
+                ++position_;
+            }
+            tokenEnd_ = position_;
+            if (position_ < end_) {
+                ++position_;
+            }
+        } else {
+            tokenBegin_ = position_;
+            while (position_ < end_ && !IsDelimiter(*position_) && !IsSpace(*position_)) {
+                ++position_;
+            }
+            tokenEnd_ = position_;
+        }
+        SkipWhiteSpaces();
+        if (position_ < end_ && IsDelimiter(*position_)) {
+            ++position_;
+        }
+        return true;
+    }
+
+private:
+    bool IsDelimiter(char c) const {
+        return c == ',' || (braces_ && (c == '{' || c == '}'));
+    }
+
+    void SkipWhiteSpaces() {
+        while (position_ < end_ && IsSpace(*position_)) {
+            ++position_;
+        }
+    }
+
+    const char* position_;
+    const char* end_;
+    const char* tokenBegin_;
+    const char* tokenEnd_;
+    bool braces_;
+};
+
+//! Gets the end of the line starting at begin
+inline const char* FindLineEnd(const char* begin, const char* end) {
+    const char* lineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    return lineEnd != NULL ? lineEnd : end;
+}
+
+//! Minimal size of a chunk parsed by one thread
+const size_t MinChunkSize = 1 << 16;
+
+//! Parses data lines of one chunk
+class ParseChunkTask : public ITask {
+public:
+    ParseChunkTask(const ArffParser* parser, const char* begin, const char* end)
+        : parser_(parser),
+          begin_(begin),
+          end_(end),
+          result_(false) {
+    }
+
+    virtual void Run() {
+        result_ = parser_->ParseData(begin_, end_, &data_);
+    }
+
+    const ArffData& GetData() const {
+        return data_;
+    }
+
+    bool GetResult() const {
+        return result_;
+    }
+
+private:
+    const ArffParser* parser_;
+    const char* begin_;
+    const char* end_;
+    ArffData data_;
+    bool result_;
+};
+
+//! Appends one feature column of all the chunks to the data
+class AppendColumnTask : public ITask {
+public:
+    AppendColumnTask(const std::vector<ParseChunkTask*>* chunks, int featureIndex, ArffData* data)
+        : chunks_(chunks),
+          featureIndex_(featureIndex),
+          data_(data) {
+    }
+
+    virtual void Run() {
+        FeatureColumn& column = data_->Features[featureIndex_];
+        int size = column.GetSize();
+        for (size_t i = 0; i < chunks_->size(); ++i) {
+            size += (*chunks_)[i]->GetData().Features[featureIndex_].GetSize();
+        }
+        column.Reserve(size);
+        for (size_t i = 0; i < chunks_->size(); ++i) {
+            column.Append((*chunks_)[i]->GetData().Features[featureIndex_]);
+        }
+    }
+
+private:
+    const std::vector<ParseChunkTask*>* chunks_;
+    int featureIndex_;
+    ArffData* data_;
+};
+
+} // namespace
+
+NominalIndex::NominalIndex(const vector<string>& names)
+    : names_(names) {
+    size_t size = 4;
+    while (size < 2 * names.size()) {
+        size *= 2;
+    }
+    slots_.assign(size, -1);
+    for (int i = 0; i < static_cast<int>(names.size()); ++i) {
+        const char* begin = names[i].data();
+        const char* end = begin + names[i].length();
+        if (Find(begin, end) != -1) {
+            continue; // the first one of equal names is used
+        }
+        size_t slot = GetHash(begin, end) & (size - 1);
+        while (slots_[slot] != -1) {
+            slot = (slot + 1) & (size - 1);
+        }
+        slots_[slot] = i;
+    }
+}
+
+int NominalIndex::Find(const char* begin, const char* end) const {
+    if (slots_.empty()) {
+        return -1;
+    }
+    size_t mask = slots_.size() - 1;
+    size_t length = end - begin;
+    for (size_t slot = GetHash(begin, end) & mask; slots_[slot] != -1; slot = (slot + 1) & mask) {
+        const string& name = names_[slots_[slot]];
+        if (name.length() == length && memcmp(name.data(), begin, length) == 0) {
+            return slots_[slot];
+        }
+    }
+    return -1;
+}
+
+unsigned int NominalIndex::GetHash(const char* begin, const char* end) {
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (; begin < end; ++begin) {
+        hash = (hash ^ static_cast<unsigned char>(*begin)) * 16777619u;
+    }
+    return hash;
+}
+
+bool ArffParser::ParseHeader(const char* begin, const char* end, MetaData* metaData, const char** dataBegin) {
+    bool relationAchieved = false;
+    for (const char* lineBegin = begin; lineBegin < end; ) {
+        const char* lineEnd = FindLineEnd(lineBegin, end);
+        const char* nextLine = lineEnd < end ? lineEnd + 1 : end;
+        LineTokenizer tokenizer(lineBegin, lineEnd);
+        lineBegin = nextLine;
+        if (tokenizer.Peek() == '%' || !tokenizer.ReadNext()) {
+            continue;
+        }
+        if (!relationAchieved) {
+            if (!tokenizer.TokenEquals("@relation") || !tokenizer.ReadNext()) {
+                return false;
+            }
+            metaData->SetName(tokenizer.GetToken());
+            relationAchieved = true;
+        } else if (tokenizer.TokenEquals("@data")) {
+            *dataBegin = nextLine;
+            return true;
+        } else if (tokenizer.TokenEquals("@attribute")) {
+            if (!tokenizer.ReadNext()) {
+                return false;
+            }
+            string attributeName = tokenizer.GetToken();
+            vector<string> nominalValues;
+            FeatureType attributeType = UnknownType;
+            if (tokenizer.Peek() != '{') {
+                if (!tokenizer.ReadNext()) {
+                    return false;
+                }
+                if (tokenizer.TokenEquals("numeric") || tokenizer.TokenEquals("real")) {
+                    attributeType = Numeric;
+                } else if (tokenizer.TokenEquals("string") || tokenizer.TokenEquals("date")) {
+                    attributeType = UnknownType;
+                } else {
+                    return false;
+                }
+            } else {
+                tokenizer.SetBraces(true);
+                tokenizer.ReadNext();
+                attributeType = Nominal;
+                while (tokenizer.ReadNext()) {
+                    nominalValues.push_back(tokenizer.GetToken());
+                }
+            }
+            if (attributeType == Nominal && attributeName == "class") {
+                metaData->SetTargetInfo(FeatureInfo(attributeName, attributeType, false, nominalValues));
+                targetIndex_ = metaData->GetFeatureCount();
+                targetIndexes_ = NominalIndex(nominalValues);
+            } else {
+                metaData->AddFeature(FeatureInfo(attributeName, attributeType, false, nominalValues));
+                featureTypes_.push_back(attributeType);
+                columnTypes_.push_back(FeatureColumn::GetCompactType(attributeType, nominalValues.size(), singlePrecision_));
+                nominalIndexes_.push_back(NominalIndex(nominalValues));
+            }
+        } else {
+            return false;
+        }
+    }
+    *dataBegin = end;
+    return true;
+}
+
+bool ArffParser::ParseData(const char* begin, const char* end, ArffData* data) const {
+    CreateColumns(data);
+    for (const char* lineBegin = begin; lineBegin < end; ) {
+        const char* lineEnd = FindLineEnd(lineBegin, end);
+        if (!ParseDataLine(lineBegin, lineEnd, data)) {
+            return false;
+        }
+        lineBegin = lineEnd < end ? lineEnd + 1 : end;
+    }
+    return true;
+}
+
+bool ArffParser::ParseData(const char* begin, const char* end, ArffData* data, ThreadPool* pool) const {
+    size_t size = end - begin;
+    size_t chunkCount = std::min<size_t>(pool->GetThreadCount(), size / MinChunkSize + 1);
+    if (chunkCount <= 1) {
+        return ParseData(begin, end, data);
+    }
+
+    std::vector<ParseChunkTask*> chunks;
+    const char* chunkBegin = begin;
+    for (size_t i = 1; i <= chunkCount && chunkBegin < end; ++i) {
+        const char* chunkEnd = end;
+        if (i < chunkCount) {
+            const char* position = std::max(begin + size * i / chunkCount, chunkBegin);
+            chunkEnd = FindLineEnd(position, end);
+            chunkEnd = chunkEnd < end ? chunkEnd + 1 : end;
+        }
+        chunks.push_back(new ParseChunkTask(this, chunkBegin, chunkEnd));
+        chunkBegin = chunkEnd;
+    }
+
+    bool result = true;
+    try {
+        pool->Run(std::vector<ITask*>(chunks.begin(), chunks.end()));
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            result = result && chunks[i]->GetResult();
+        }
+        if (result) {
+            int featureCount = featureTypes_.size();
+            CreateColumns(data);
+            std::vector<AppendColumnTask> appendTasks;
+            appendTasks.reserve(featureCount);
+            for (int j = 0; j < featureCount; ++j) {
+                appendTasks.push_back(AppendColumnTask(&chunks, j, data));
+            }
+            std::vector<ITask*> tasks;
+            for (int j = 0; j < featureCount; ++j) {
+                tasks.push_back(&appendTasks[j]);
+            }
+            pool->Run(tasks);
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                const ArffData& chunkData = chunks[i]->GetData();
+                data->ObjectCount += chunkData.ObjectCount;
+                data->Targets.Append(chunkData.Targets.GetData(), chunkData.Targets.GetSize());
+                for (int j = 0; j < featureCount; ++j) {
+                    if (chunkData.Missed[j]) {
+                        data->Missed[j] = true;
+                    }
+                }
+            }
+        }
+    } catch (...) {
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            delete chunks[i];
+        }
+        throw;
+    }
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        delete chunks[i];
+    }
+    return result;
+}
+
+void ArffParser::CreateColumns(ArffData* data) const {
+    for (size_t j = data->Features.size(); j < columnTypes_.size(); ++j) {
+        data->Features.push_back(FeatureColumn(columnTypes_[j]));
+    }
+    data->Missed.resize(featureTypes_.size(), false);
+}
+
+bool ArffParser::ParseDataLine(const char* begin, const char* end, ArffData* data) const {
+    LineTokenizer tokenizer(begin, end);
+    if (tokenizer.Peek() == '%' || tokenizer.Peek() == '\0') {
+        return true;
+    }
+    if (targetIndex_ == -1) {
+        return false;
+    }
+    int featureCount = featureTypes_.size();
+    int attributeIndex;
+    for (attributeIndex = 0; tokenizer.ReadNext(); ++attributeIndex) {
+        if (attributeIndex > featureCount) {
+            return false;
+        }
+        const char* tokenBegin = tokenizer.GetTokenBegin();
+        const char* tokenEnd = tokenizer.GetTokenEnd();
+        if (attributeIndex == targetIndex_) {
+            int target = targetIndexes_.Find(tokenBegin, tokenEnd);
+            if (target == -1) {
+                return false;
+            }
+            data->Targets.PushBack(target);
+            continue;
+        }
+        int featureIndex = attributeIndex > targetIndex_ ? attributeIndex - 1 : attributeIndex;
+        double feature = 0;
+        if (tokenEnd - tokenBegin == 1 && *tokenBegin == '?') {
+            data->Missed[featureIndex] = true;
+            feature = NaN;
+        } else if (featureTypes_[featureIndex] == Numeric) {
+            if (!ParseDouble(tokenBegin, tokenEnd, &feature)) {
+                return false;
+            }
+        } else if (featureTypes_[featureIndex] == Nominal) {
+            int index = nominalIndexes_[featureIndex].Find(tokenBegin, tokenEnd);
+            if (index == -1) {
+                return false;
+            }
+            feature = index;
+        }
+        data->Features[featureIndex].PushBack(feature);
+    }
+    if (attributeIndex != featureCount + 1) {
+        return false;
+    }
+    ++data->ObjectCount;
+    return true;
+}
+
+} // namespace mll
@@ -0,0 +1,97 @@
+#ifndef ARFF_PARSER_H_
+#define ARFF_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include "aligned_array.h"
+#include "column.h"
+#include "metadata.h"
+
+namespace mll {
+
+class ThreadPool;
+
+//! Hash table of nominal values names
+class NominalIndex {
+public:
+    //! Default initialization (empty table)
+    NominalIndex() {
+    }
+
+    //! Builds the table of the names
+    explicit NominalIndex(const std::vector<std::string>& names);
+
+    //! Gets index of the name [begin, end) or -1 if there is no such name
+    int Find(const char* begin, const char* end) const;
+
+private:
+    //! Calculates hash of the characters
+    static unsigned int GetHash(const char* begin, const char* end);
+
+    std::vector<std::string> names_;    //!< Names
+    std::vector<int> slots_;            //!< Open addressing table of names indices (-1 for empty)
+};
+
+//! Objects parsed from ARFF data lines
+struct ArffData {
+    //! Default initialization (no objects)
+    ArffData()
+        : ObjectCount(0) {
+    }
+
+    //! Number of objects
+    int ObjectCount;
+    //! Feature columns
+    std::vector<FeatureColumn> Features;
+    //! Targets
+    AlignedArray<int> Targets;
+    //! If the features have missed values
+    std::vector<bool> Missed;
+};
+
+//! ARFF parser.
+/*! Works in place on a memory buffer (e.g. memory-mapped file): tokens are
+    ranges of the buffer, so nothing is copied while data lines are parsed.
+*/
+class ArffParser {
+public:
+    //! Default initialization (numeric features are parsed to float columns if singlePrecision)
+    explicit ArffParser(bool singlePrecision = false)
+        : targetIndex_(-1),
+          singlePrecision_(singlePrecision) {
+    }
+
+    /*! Parses ARFF header from the buffer [begin, end) to the metadata.
+        Stores position of the first data line to dataBegin (end if there is no data section).
+        Returns false if the header is incorrect.
+    */
+    bool ParseHeader(const char* begin, const char* end, MetaData* metaData, const char** dataBegin);
+
+    //! Parses data lines [begin, end) appending objects to the data. Returns false on errors.
+    bool ParseData(const char* begin, const char* end, ArffData* data) const;
+
+    /*! Parses data lines [begin, end) on the pool of threads: the buffer is split
+        into chunks by line boundaries which are parsed into separate columns and
+        then appended to the data in order, so the result is the same as the one of
+        serial parsing. Returns false on errors.
+    */
+    bool ParseData(const char* begin, const char* end, ArffData* data, ThreadPool* pool) const;
+
+private:
+    //! Parses one data line, returns false on errors
+    bool ParseDataLine(const char* begin, const char* end, ArffData* data) const;
+    //! Creates typed feature columns if they are not created yet
+    void CreateColumns(ArffData* data) const;
+
+    int targetIndex_;                           //!< Index of the target attribute
+    bool singlePrecision_;                      //!< If numeric features are stored as floats
+    std::vector<FeatureType> featureTypes_;     //!< Feature types
+    std::vector<ColumnType> columnTypes_;       //!< Types of feature columns
+    std::vector<NominalIndex> nominalIndexes_;  //!< Feature nominal values
+    NominalIndex targetIndexes_;                //!< Target nominal values
+};
+
+} // namespace mll
+
+#endif // ARFF_PARSER_H_
@@ -0,0 +1,127 @@
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "arff_parser.h"
+#include "thread_pool.h"
+#include "util.h"
+
+using namespace mll;
+
+class ArffParserTest : public testing::Test {
+protected:
+	static bool Parse(const char* input, double* value) {
+		return ParseDouble(input, input + strlen(input), value);
+	}
+};
+
+TEST_F(ArffParserTest, ParseDoubleTest)
+{
+	const char* numbers[] = {
+		"0", "-0", "1", "+2.5", "-3.25", "0.1", ".5", "5.", "1e10", "1E-5",
+		"123456789012345678901234567890", "2.2250738585072014e-308",
+		"1.7976931348623157e308", "0.30000000000000004", "4.9e-324"
+	};
+	for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i) {
+		double value;
+		ASSERT_TRUE(Parse(numbers[i], &value)) << numbers[i];
+		ASSERT_EQ(strtod(numbers[i], NULL), value) << numbers[i];
+	}
+
+	const char* invalid[] = { "", "-", ".", "e5", "1e", "1.5x", "abc", "1 " };
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); ++i) {
+		double value;
+		ASSERT_FALSE(Parse(invalid[i], &value)) << invalid[i];
+	}
+}
+
+TEST_F(ArffParserTest, ParseTest)
+{
+	const char input[] =
+		"% comment\n"
+		"@RELATION test\n"
+		"\n"
+		"@attribute x numeric\n"
+		"@attribute 'class' {yes,no}\n"
+		"@attribute class {a, b}\n"
+		"@attribute s string\n"
+		"@data\n"
+		"1.5, no, b, str\r\n"
+		"  % comment\n"
+		"?, yes, a, \"quoted string\"\n";
+
+	MetaData metaData;
+	ArffParser parser;
+	const char* dataBegin;
+	ASSERT_TRUE(parser.ParseHeader(input, input + sizeof(input) - 1, &metaData, &dataBegin));
+	ASSERT_EQ("test", metaData.GetName());
+	ASSERT_EQ(3, metaData.GetFeatureCount());
+	ASSERT_EQ(2u, metaData.GetTargetInfo().NominalValues.size());
+
+	ArffData data;
+	ASSERT_TRUE(parser.ParseData(dataBegin, input + sizeof(input) - 1, &data));
+	ASSERT_EQ(2, data.ObjectCount);
+	ASSERT_EQ(1, data.Targets.Get(0));
+	ASSERT_EQ(0, data.Targets.Get(1));
+	ASSERT_EQ(1.5, data.Features[0].Get(0));
+	ASSERT_TRUE(IsNaN(data.Features[0].Get(1)));
+	ASSERT_EQ(1.0, data.Features[1].Get(0));
+	ASSERT_EQ(UInt8Column, data.Features[1].GetType());
+	ASSERT_EQ(1, data.Features[1].GetCode(0));
+	ASSERT_EQ(0.0, data.Features[2].Get(1));
+	ASSERT_TRUE(data.Missed[0]);
+	ASSERT_FALSE(data.Missed[1]);
+
+	const char wrong[] = "1.5, c, b, str\n";
+	ArffData wrongData;
+	ASSERT_FALSE(parser.ParseData(wrong, wrong + sizeof(wrong) - 1, &wrongData));
+}
+
+TEST_F(ArffParserTest, ParallelParseTest)
+{
+	std::ostringstream input;
+	input << "@relation parallel\n@attribute x numeric\n@attribute y {a,b,c}\n"
+		<< "@attribute class {p,n}\n@data\n";
+	for (int i = 0; i < 20000; ++i) {
+		if (i % 100 == 0) {
+			input << "% comment\n\n";
+		}
+		input << (i % 7 == 0 ? std::string("?") : ToString(i * 0.25)) << ","
+			<< static_cast<char>('a' + i % 3) << "," << (i % 2 ? "p" : "n") << "\n";
+	}
+	std::string buffer = input.str();
+	const char* end = buffer.data() + buffer.length();
+
+	MetaData metaData;
+	ArffParser parser;
+	const char* dataBegin;
+	ASSERT_TRUE(parser.ParseHeader(buffer.data(), end, &metaData, &dataBegin));
+
+	ArffData serialData;
+	ASSERT_TRUE(parser.ParseData(dataBegin, end, &serialData));
+	ASSERT_EQ(20000, serialData.ObjectCount);
+
+	ThreadPool pool(4);
+	ArffData parallelData;
+	ASSERT_TRUE(parser.ParseData(dataBegin, end, &parallelData, &pool));
+	ASSERT_EQ(serialData.ObjectCount, parallelData.ObjectCount);
+	ASSERT_TRUE(serialData.Missed == parallelData.Missed);
+	ASSERT_EQ(0, memcmp(serialData.Targets.GetData(), parallelData.Targets.GetData(),
+		serialData.ObjectCount * sizeof(int)));
+	for (int j = 0; j < 2; ++j) {
+		ASSERT_EQ(serialData.Features[j].GetType(), parallelData.Features[j].GetType());
+		ASSERT_EQ(serialData.Features[j].GetRawSize(), parallelData.Features[j].GetRawSize());
+		ASSERT_EQ(0, memcmp(serialData.Features[j].GetRawData(), parallelData.Features[j].GetRawData(),
+			serialData.Features[j].GetRawSize()));
+		ASSERT_EQ(serialData.Features[j].CountPresent(0, serialData.ObjectCount),
+			parallelData.Features[j].CountPresent(0, serialData.ObjectCount));
+	}
+
+	std::string wrong = buffer + "1,d,p\n";
+	ArffData wrongData;
+	ASSERT_FALSE(parser.ParseData(dataBegin - buffer.data() + wrong.data(),
+		wrong.data() + wrong.length(), &wrongData, &pool));
+}
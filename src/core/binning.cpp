@@ -0,0 +1,107 @@
+#include "binning.h"
+
+#include <stdexcept>
+
+#include "thread_pool.h"
+#include "util.h"
+
+using std::vector;
+
+namespace mll {
+
+class FeatureBinning::BuildRunner {
+public:
+    BuildRunner(const IDataSet* data, int binCount, FeatureBinning* binning,
+                vector< sh_ptr< const vector<int> > >* orders)
+        : data_(data),
+          binCount_(binCount),
+          binning_(binning),
+          orders_(orders) {
+    }
+
+    void operator() (int first, int last) const;
+
+private:
+    const IDataSet* data_;
+    int binCount_;
+    FeatureBinning* binning_;
+    vector< sh_ptr< const vector<int> > >* orders_;
+};
+
+void FeatureBinning::Build(const IDataSet& data, int binCount /*= MaxBinCount*/, int threadCount /*= 1*/,
+                           vector< sh_ptr< const vector<int> > >* orders /*= NULL*/) {
+    if (binCount < 1 || binCount > MaxBinCount) {
+        throw std::out_of_range("Number of bins is out of range");
+    }
+    objectCount_ = data.GetObjectCount();
+    features_.clear();
+    features_.resize(data.GetFeatureCount());
+    if (orders != NULL) {
+        orders->clear();
+        orders->resize(GetFeatureCount());
+    }
+    ParallelForThreads(0, GetFeatureCount(), BuildRunner(&data, binCount, this, orders), threadCount);
+}
+
+void FeatureBinning::BuildFeature(const IDataSet& data, int featureIndex, int binCount,
+                                  sh_ptr< const vector<int> >* order) {
+    FeatureBins& bins = features_[featureIndex];
+    bins.Codes = AlignedArray<uint8_t>(objectCount_, MissedBin);
+    sh_ptr< const vector<int> > sortedIndexes = data.GetSortedObjectIndexes(featureIndex);
+    if (order != NULL) {
+        *order = sortedIndexes;
+    }
+    if (objectCount_ == 0) {
+        return;
+    }
+    // values in the order of the objects, missed ones are the last
+    vector<double> values(objectCount_);
+    const int* indexes = &sortedIndexes->at(0);
+    data.GatherFeatures(featureIndex, indexes, objectCount_, &values[0]);
+    int presentCount = objectCount_;
+    while (presentCount > 0 && IsNaN(values[presentCount - 1])) {
+        --presentCount;
+    }
+    uint8_t* codes = bins.Codes.GetData();
+    int begin = 0;
+    while (begin < presentCount) {
+        // the rest objects are split evenly by the rest bins
+        int restBinCount = binCount - static_cast<int>(bins.Maxs.size());
+        int end = begin + (presentCount - begin + restBinCount - 1) / restBinCount;
+        while (end < presentCount && values[end] == values[end - 1]) {
+            ++end;
+        }
+        uint8_t code = static_cast<uint8_t>(bins.Maxs.size());
+        for (int i = begin; i < end; ++i) {
+            codes[indexes[i]] = code;
+        }
+        bins.Mins.push_back(values[begin]);
+        bins.Maxs.push_back(values[end - 1]);
+        begin = end;
+    }
+}
+
+double FeatureBinning::GetThreshold(int featureIndex, int bin) const {
+    const FeatureBins& bins = features_.at(featureIndex);
+    if (bin + 1 < static_cast<int>(bins.Maxs.size())) {
+        return (bins.Maxs.at(bin) + bins.Mins.at(bin + 1)) / 2;
+    } else {
+        return bins.Maxs.at(bin) + 1.0;
+    }
+}
+
+void AccumulateHistogram(const uint8_t* codes, const int* targets, const double* weights,
+                         int objectCount, int classCount, double* sums) {
+    for (int i = 0; i < objectCount; ++i) {
+        sums[codes[i] * classCount + targets[i]] += weights[i];
+    }
+}
+
+void FeatureBinning::BuildRunner::operator() (int first, int last) const {
+    for (int featureIndex = first; featureIndex < last; ++featureIndex) {
+        binning_->BuildFeature(*data_, featureIndex, binCount_,
+                               orders_ != NULL ? &orders_->at(featureIndex) : NULL);
+    }
+}
+
+} // namespace mll
@@ -0,0 +1,98 @@
+#ifndef BINNING_H_
+#define BINNING_H_
+
+#include <stdint.h>
+#include <vector>
+
+#include "aligned_array.h"
+#include "data.h"
+
+namespace mll {
+
+//! Maximal number of bins of feature values (one more code is kept for missed values)
+const int MaxBinCount = 255;
+//! Code of missed feature values
+const uint8_t MissedBin = 255;
+
+//! Features quantized to quantile bins and stored as uint8 codes
+/*! Bins are built once by the cached orders of objects and hold nearly equal
+    numbers of objects. Equal values always fall into one bin, so features with
+    at most binCount distinct values are binned exactly. Learners scan the bins
+    instead of sorting objects: weights are summed by bins in one pass over the
+    codes (see AccumulateHistogram).
+*/
+class FeatureBinning {
+public:
+    //! Default initialization (no features)
+    FeatureBinning()
+        : objectCount_(0) {
+    }
+
+    //! Quantizes all features of the data into at most binCount bins each
+    /*! Features are binned on threadCount threads of the global pool (0 for all its threads).
+        The orders of objects the bins are built by are stored to orders if it's not NULL.
+    */
+    void Build(const IDataSet& data, int binCount = MaxBinCount, int threadCount = 1,
+               std::vector< sh_ptr< const std::vector<int> > >* orders = NULL);
+
+    //! Number of binned objects
+    int GetObjectCount() const {
+        return objectCount_;
+    }
+
+    //! Number of binned features
+    int GetFeatureCount() const {
+        return static_cast<int>(features_.size());
+    }
+
+    //! Number of bins of the present feature values (their codes are less than it)
+    int GetBinCount(int featureIndex) const {
+        return static_cast<int>(features_.at(featureIndex).Maxs.size());
+    }
+
+    //! Codes of the feature values of all objects (MissedBin for missed values)
+    const uint8_t* GetCodes(int featureIndex) const {
+        return features_.at(featureIndex).Codes.GetData();
+    }
+
+    //! Least feature value in the bin
+    double GetBinMin(int featureIndex, int bin) const {
+        return features_.at(featureIndex).Mins.at(bin);
+    }
+
+    //! Greatest feature value in the bin
+    double GetBinMax(int featureIndex, int bin) const {
+        return features_.at(featureIndex).Maxs.at(bin);
+    }
+
+    //! Gets the threshold between values of the bin and of the next one (above values of the last bin)
+    double GetThreshold(int featureIndex, int bin) const;
+
+private:
+    //! Bins a range of features
+    class BuildRunner;
+
+    //! Quantizes the feature (features are binned independently)
+    void BuildFeature(const IDataSet& data, int featureIndex, int binCount,
+                      sh_ptr< const std::vector<int> >* order);
+
+    //! Bins of one feature
+    struct FeatureBins {
+        AlignedArray<uint8_t> Codes;    //!< Codes of the objects
+        std::vector<double> Mins;       //!< Least values of the bins
+        std::vector<double> Maxs;       //!< Greatest values of the bins
+    };
+
+    int objectCount_;                       //!< Number of objects
+    std::vector<FeatureBins> features_;     //!< Bins of the features
+};
+
+//! Adds weights of the objects to the sums by bins and classes: sums[code * classCount + target]
+/*! sums must hold (MissedBin + 1) * classCount values.
+*/
+void AccumulateHistogram(const uint8_t* codes, const int* targets, const double* weights,
+                         int objectCount, int classCount, double* sums);
+
+} // namespace mll
+
+#endif // BINNING_H_
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "binning.h"
+#include "dataset.h"
+
+using namespace mll;
+
+class BinningTest : public testing::Test { };
+
+TEST_F(BinningTest, QuantileBinsTest)
+{
+	const int OBJECTS = 1000;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	classes.push_back("2");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 3);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, (i * 7) % OBJECTS);
+		dataSet.SetFeature(i, 1, i % 5 == 0 ? NaN : i % 4);
+		dataSet.SetFeature(i, 2, i < 900 ? 0.0 : i);
+		dataSet.SetTarget(i, i % 3);
+		dataSet.SetWeight(i, 1.0 + i % 2);
+	}
+
+	FeatureBinning binning;
+	binning.Build(dataSet, 10);
+	ASSERT_EQ(OBJECTS, binning.GetObjectCount());
+	ASSERT_EQ(3, binning.GetFeatureCount());
+
+	// Distinct values are split evenly, codes follow the order of values
+	ASSERT_EQ(10, binning.GetBinCount(0));
+	std::vector<int> counts(10);
+	for (int i = 0; i < OBJECTS; i++) {
+		int code = binning.GetCodes(0)[i];
+		counts.at(code)++;
+		ASSERT_LE(binning.GetBinMin(0, code), dataSet.GetFeature(i, 0));
+		ASSERT_GE(binning.GetBinMax(0, code), dataSet.GetFeature(i, 0));
+	}
+	for (int bin = 0; bin < 10; bin++) {
+		ASSERT_EQ(OBJECTS / 10, counts[bin]);
+	}
+	ASSERT_EQ(99.5, binning.GetThreshold(0, 0));
+
+	// Few distinct values are binned exactly, missed values get their own code
+	ASSERT_EQ(4, binning.GetBinCount(1));
+	for (int i = 0; i < OBJECTS; i++) {
+		if (i % 5 == 0) {
+			ASSERT_EQ(MissedBin, binning.GetCodes(1)[i]);
+		} else {
+			ASSERT_EQ(i % 4, binning.GetCodes(1)[i]);
+		}
+	}
+	ASSERT_EQ(2.5, binning.GetThreshold(1, 2));
+	ASSERT_EQ(4.0, binning.GetThreshold(1, 3));
+
+	// Equal values are never split
+	ASSERT_EQ(0, binning.GetCodes(2)[0]);
+	ASSERT_EQ(0, binning.GetCodes(2)[899]);
+	ASSERT_EQ(0.0, binning.GetBinMax(2, 0));
+	ASSERT_LE(binning.GetBinCount(2), 10);
+	ASSERT_THROW(binning.Build(dataSet, MaxBinCount + 1), std::out_of_range);
+
+	// Histogram sums weights by bins and classes
+	std::vector<int> targets(OBJECTS);
+	std::vector<double> weights(OBJECTS);
+	dataSet.GetTargets(0, OBJECTS, &targets[0]);
+	dataSet.GetWeights(0, OBJECTS, &weights[0]);
+	std::vector<double> sums((MissedBin + 1) * 3);
+	AccumulateHistogram(binning.GetCodes(1), &targets[0], &weights[0], OBJECTS, 3, &sums[0]);
+	std::vector<double> expected((MissedBin + 1) * 3);
+	for (int i = 0; i < OBJECTS; i++) {
+		int code = i % 5 == 0 ? MissedBin : i % 4;
+		expected[code * 3 + i % 3] += 1.0 + i % 2;
+	}
+	ASSERT_TRUE(sums == expected);
+}
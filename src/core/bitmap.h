@@ -0,0 +1,210 @@
+#ifndef BITMAP_H_
+#define BITMAP_H_
+
+#include <stdint.h>
+
+#include "aligned_array.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace mll {
+
+//! Number of bits in a bitmap word
+const int BitmapWordSize = 64;
+
+//! Counts set bits of the word
+inline int PopCount(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(word));
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+//! Gets index of the lowest set bit of the word (which must be non-zero)
+inline int CountTrailingZeros(uint64_t word) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return PopCount((word & (~word + 1)) - 1);
+#endif
+}
+
+//! Array of bits packed into 64-bit words.
+/*! Bits beyond the size are always zero, so the words can be counted as they are.
+    The words can refer to external memory like AlignedArray elements do.
+*/
+class Bitmap {
+public:
+    //! Creates empty bitmap
+    Bitmap()
+        : size_(0) {
+    }
+
+    //! Creates bitmap of the given size with all bits set to the value
+    explicit Bitmap(int size, bool value = false)
+        : size_(0) {
+        Resize(size, value);
+    }
+
+    //! Number of bits
+    int GetSize() const {
+        return size_;
+    }
+
+    //! Number of words
+    int GetWordCount() const {
+        return words_.GetSize();
+    }
+
+    //! Pointer to the first word
+    const uint64_t* GetWords() const {
+        return words_.GetData();
+    }
+
+    //! Gets the word with the index
+    uint64_t GetWord(int wordIndex) const {
+        return words_.Get(wordIndex);
+    }
+
+    //! Gets the bit with the index
+    bool Get(int index) const {
+        return (words_.Get(index / BitmapWordSize) >> (index % BitmapWordSize) & 1) != 0;
+    }
+
+    //! Sets the bit with the index
+    void Set(int index, bool value) {
+        uint64_t* words = words_.GetData();
+        uint64_t mask = static_cast<uint64_t>(1) << (index % BitmapWordSize);
+        if (value) {
+            words[index / BitmapWordSize] |= mask;
+        } else {
+            words[index / BitmapWordSize] &= ~mask;
+        }
+    }
+
+    //! Appends one bit to the end
+    void PushBack(bool value) {
+        if (size_ % BitmapWordSize == 0) {
+            words_.PushBack(0);
+        }
+        ++size_;
+        if (value) {
+            Set(size_ - 1, true);
+        }
+    }
+
+    //! Resizes bitmap setting new bits to the value
+    void Resize(int size, bool value = false) {
+        if (size < size_) {
+            words_.Resize(GetWordCount(size));
+            size_ = size;
+            ClearTail();
+            return;
+        }
+        int oldSize = size_;
+        words_.Resize(GetWordCount(size), value ? ~static_cast<uint64_t>(0) : 0);
+        size_ = size;
+        if (value) {
+            // the last old word may be partially filled
+            for (int i = oldSize; i < size && i % BitmapWordSize != 0; ++i) {
+                Set(i, true);
+            }
+        }
+        ClearTail();
+    }
+
+    //! Swaps two bits
+    void Swap(int index1, int index2) {
+        bool value1 = Get(index1);
+        bool value2 = Get(index2);
+        if (value1 != value2) {
+            Set(index1, value2);
+            Set(index2, value1);
+        }
+    }
+
+    //! Moves bit indexes[i] to position i for all i (indexes must be a permutation)
+    void Permute(const int* indexes) {
+        AlignedArray<uint64_t> words(GetWordCount());
+        uint64_t* data = words.GetData();
+        for (int i = 0; i < size_; ++i) {
+            if (Get(indexes[i])) {
+                data[i / BitmapWordSize] |= static_cast<uint64_t>(1) << (i % BitmapWordSize);
+            }
+        }
+        words_.Swap(words);
+    }
+
+    //! Removes all bits
+    void Clear() {
+        words_.Clear();
+        size_ = 0;
+    }
+
+    //! Refers to external words which must outlive the bitmap
+    void SetExternal(const uint64_t* words, int size) {
+        words_.SetExternal(words, GetWordCount(size));
+        size_ = size;
+    }
+
+    //! Counts set bits in the range [index, index + count)
+    int CountSetBits(int index, int count) const {
+        int result = 0;
+        for (int end = index + count; index < end; ) {
+            int bitCount;
+            uint64_t word = GetRangeWord(index, end, &bitCount);
+            result += PopCount(word);
+            index += bitCount;
+        }
+        return result;
+    }
+
+    /*! Gets bits of the range [index, end) which are in the same word as the index,
+        shifted so that the bit index is the lowest one. Stores the number of the bits to bitCount.
+    */
+    uint64_t GetRangeWord(int index, int end, int* bitCount) const {
+        int shift = index % BitmapWordSize;
+        uint64_t word = words_.Get(index / BitmapWordSize) >> shift;
+        *bitCount = BitmapWordSize - shift;
+        if (end - index < *bitCount) {
+            *bitCount = end - index;
+            word &= (static_cast<uint64_t>(1) << *bitCount) - 1;
+        }
+        return word;
+    }
+
+    //! Number of words to store the number of bits
+    static int GetWordCount(int size) {
+        return (size + BitmapWordSize - 1) / BitmapWordSize;
+    }
+
+private:
+    //! Resets bits beyond the size
+    void ClearTail() {
+        if (size_ % BitmapWordSize != 0) {
+            uint64_t mask = (static_cast<uint64_t>(1) << (size_ % BitmapWordSize)) - 1;
+            if ((words_.Get(size_ / BitmapWordSize) & ~mask) != 0) {
+                words_.GetData()[size_ / BitmapWordSize] &= mask;
+            }
+        }
+    }
+
+    AlignedArray<uint64_t> words_;  //!< Words of bits
+    int size_;                      //!< Number of bits
+};
+
+} // namespace mll
+
+#endif // BITMAP_H_
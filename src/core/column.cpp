@@ -0,0 +1,595 @@
+#include "column.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace mll {
+
+const void* FeatureColumn::GetRawData() const {
+    switch (type_) {
+        case UInt8Column:
+            return bytes_.GetData();
+        case UInt16Column:
+            return shorts_.GetData();
+        case BitColumn:
+            return bits_.GetWords();
+        case FloatColumn:
+            return floats_.GetData();
+        default:
+            return doubles_.GetData();
+    }
+}
+
+size_t FeatureColumn::GetRawSize() const {
+    switch (type_) {
+        case UInt8Column:
+            return size_ * sizeof(uint8_t);
+        case UInt16Column:
+            return size_ * sizeof(uint16_t);
+        case BitColumn:
+            return Bitmap::GetWordCount(size_) * sizeof(uint64_t);
+        case FloatColumn:
+            return size_ * sizeof(float);
+        default:
+            return size_ * sizeof(double);
+    }
+}
+
+void FeatureColumn::Set(int index, double value) {
+    if (!CanStore(type_, value)) {
+        ConvertTo(DoubleColumn);
+    }
+    if (IsNaN(value)) {
+        if (!trackMissing_) {
+            TrackMissing();
+        }
+        present_.Set(index, false);
+    } else if (trackMissing_) {
+        present_.Set(index, true);
+    }
+    SetStored(index, value);
+}
+
+void FeatureColumn::PushBack(double value) {
+    if (!CanStore(type_, value)) {
+        ConvertTo(DoubleColumn);
+    }
+    if (IsNaN(value) && !trackMissing_) {
+        TrackMissing();
+    }
+    if (trackMissing_) {
+        present_.PushBack(!IsNaN(value));
+    }
+    PushBackStored(value);
+}
+
+void FeatureColumn::Append(const FeatureColumn& column) {
+    if (column.type_ != type_) {
+        Reserve(size_ + column.size_);
+        for (int i = 0; i < column.size_; ++i) {
+            PushBack(column.Get(i));
+        }
+        return;
+    }
+    int size = size_;
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Append(column.bytes_.GetData(), column.size_);
+            break;
+        case UInt16Column:
+            shorts_.Append(column.shorts_.GetData(), column.size_);
+            break;
+        case BitColumn:
+            bits_.Resize(size + column.size_);
+            for (int i = 0; i < column.size_; ++i) {
+                if (column.bits_.Get(i)) {
+                    bits_.Set(size + i, true);
+                }
+            }
+            break;
+        case FloatColumn:
+            floats_.Append(column.floats_.GetData(), column.size_);
+            break;
+        default:
+            doubles_.Append(column.doubles_.GetData(), column.size_);
+            break;
+    }
+    size_ += column.size_;
+    if (column.trackMissing_ && !trackMissing_) {
+        // present bits of the own values are set, appended ones are copied below
+        trackMissing_ = true;
+        present_.Resize(0);
+        present_.Resize(size, true);
+    }
+    if (trackMissing_) {
+        present_.Resize(size_, true);
+        if (column.trackMissing_) {
+            for (int i = 0; i < column.size_; ++i) {
+                if (!column.present_.Get(i)) {
+                    present_.Set(size + i, false);
+                }
+            }
+        }
+    }
+}
+
+void FeatureColumn::Resize(int size, double value) {
+    if (!CanStore(type_, value)) {
+        ConvertTo(DoubleColumn);
+    }
+    if (IsNaN(value) && !trackMissing_) {
+        TrackMissing();
+    }
+    double stored = IsNaN(value) && !StoresNaN(type_) ? 0 : value;
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Resize(size, static_cast<uint8_t>(stored));
+            break;
+        case UInt16Column:
+            shorts_.Resize(size, static_cast<uint16_t>(stored));
+            break;
+        case BitColumn:
+            bits_.Resize(size, stored != 0);
+            break;
+        case FloatColumn:
+            floats_.Resize(size, static_cast<float>(stored));
+            break;
+        default:
+            doubles_.Resize(size, stored);
+            break;
+    }
+    if (trackMissing_) {
+        present_.Resize(size, !IsNaN(value));
+    }
+    size_ = size;
+}
+
+void FeatureColumn::Reserve(int size) {
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Reserve(size);
+            break;
+        case UInt16Column:
+            shorts_.Reserve(size);
+            break;
+        case BitColumn:
+            break;
+        case FloatColumn:
+            floats_.Reserve(size);
+            break;
+        default:
+            doubles_.Reserve(size);
+            break;
+    }
+}
+
+void FeatureColumn::Swap(int index1, int index2) {
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Swap(index1, index2);
+            break;
+        case UInt16Column:
+            shorts_.Swap(index1, index2);
+            break;
+        case BitColumn:
+            bits_.Swap(index1, index2);
+            break;
+        case FloatColumn:
+            floats_.Swap(index1, index2);
+            break;
+        default:
+            doubles_.Swap(index1, index2);
+            break;
+    }
+    if (trackMissing_) {
+        present_.Swap(index1, index2);
+    }
+}
+
+void FeatureColumn::Permute(const int* indexes) {
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Permute(indexes);
+            break;
+        case UInt16Column:
+            shorts_.Permute(indexes);
+            break;
+        case BitColumn:
+            bits_.Permute(indexes);
+            break;
+        case FloatColumn:
+            floats_.Permute(indexes);
+            break;
+        default:
+            doubles_.Permute(indexes);
+            break;
+    }
+    if (trackMissing_) {
+        present_.Permute(indexes);
+    }
+}
+
+void FeatureColumn::Clear() {
+    doubles_.Clear();
+    bytes_.Clear();
+    shorts_.Clear();
+    bits_.Clear();
+    floats_.Clear();
+    present_.Clear();
+    size_ = 0;
+    trackMissing_ = false;
+}
+
+bool FeatureColumn::ConvertTo(ColumnType type) {
+    if (type == type_) {
+        return true;
+    }
+    for (int i = 0; i < size_; ++i) {
+        if (IsPresent(i) && !CanStore(type, GetStored(i))) {
+            return false;
+        }
+    }
+    FeatureColumn column(type);
+    column.Reserve(size_);
+    for (int i = 0; i < size_; ++i) {
+        column.PushBackStored(IsPresent(i) ? GetStored(i) : NaN);
+    }
+    type_ = type;
+    doubles_.Swap(column.doubles_);
+    bytes_.Swap(column.bytes_);
+    shorts_.Swap(column.shorts_);
+    floats_.Swap(column.floats_);
+    std::swap(bits_, column.bits_);
+    return true;
+}
+
+void FeatureColumn::SetExternal(ColumnType type, const void* values, int size) {
+    Clear();
+    type_ = type;
+    switch (type_) {
+        case UInt8Column:
+            bytes_.SetExternal(static_cast<const uint8_t*>(values), size);
+            break;
+        case UInt16Column:
+            shorts_.SetExternal(static_cast<const uint16_t*>(values), size);
+            break;
+        case BitColumn:
+            bits_.SetExternal(static_cast<const uint64_t*>(values), size);
+            break;
+        case FloatColumn:
+            floats_.SetExternal(static_cast<const float*>(values), size);
+            break;
+        default:
+            doubles_.SetExternal(static_cast<const double*>(values), size);
+            break;
+    }
+    size_ = size;
+}
+
+void FeatureColumn::TrackMissing() {
+    if (!trackMissing_) {
+        trackMissing_ = true;
+        present_.Resize(0);
+        present_.Resize(size_, true);
+    }
+    UpdateMissing();
+}
+
+void FeatureColumn::UpdateMissing() {
+    if (!StoresNaN(type_)) {
+        // other types can't store NaN, the bitmap is kept up to date
+        return;
+    }
+    if (!trackMissing_) {
+        for (int i = 0; i < size_ && !trackMissing_; ++i) {
+            trackMissing_ = IsNaN(GetStored(i));
+        }
+        if (!trackMissing_) {
+            return;
+        }
+    }
+    present_.Resize(0);
+    present_.Resize(size_, true);
+    for (int i = 0; i < size_; ++i) {
+        if (IsNaN(GetStored(i))) {
+            present_.Set(i, false);
+        }
+    }
+}
+
+void FeatureColumn::GetValues(int index, int count, double* values) const {
+    GetValuesAs(index, count, values);
+}
+
+void FeatureColumn::GetValues(int index, int count, float* values) const {
+    GetValuesAs(index, count, values);
+}
+
+void FeatureColumn::GatherValues(const int* indexes, int count, double* values) const {
+    GatherValuesAs(indexes, count, values);
+}
+
+void FeatureColumn::GatherValues(const int* indexes, int count, float* values) const {
+    GatherValuesAs(indexes, count, values);
+}
+
+void FeatureColumn::GetCodes(int index, int count, int* codes) const {
+    switch (type_) {
+        case UInt8Column:
+            std::copy(bytes_.GetData() + index, bytes_.GetData() + index + count, codes);
+            break;
+        case UInt16Column:
+            std::copy(shorts_.GetData() + index, shorts_.GetData() + index + count, codes);
+            break;
+        case BitColumn:
+            for (int i = 0; i < count; ++i) {
+                codes[i] = bits_.Get(index + i);
+            }
+            break;
+        default:
+            for (int i = 0; i < count; ++i) {
+                codes[i] = GetCode(index + i);
+            }
+            return;
+    }
+    if (trackMissing_) {
+        for (int i = 0; i < count; ++i) {
+            if (!present_.Get(index + i)) {
+                codes[i] = -1;
+            }
+        }
+    }
+}
+
+void FeatureColumn::GatherCodes(const int* indexes, int count, int* codes) const {
+    switch (type_) {
+        case UInt8Column: {
+            const uint8_t* data = bytes_.GetData();
+            for (int i = 0; i < count; ++i) {
+                codes[i] = data[indexes[i]];
+            }
+            break;
+        }
+        case UInt16Column: {
+            const uint16_t* data = shorts_.GetData();
+            for (int i = 0; i < count; ++i) {
+                codes[i] = data[indexes[i]];
+            }
+            break;
+        }
+        default:
+            for (int i = 0; i < count; ++i) {
+                codes[i] = GetCode(indexes[i]);
+            }
+            return;
+    }
+    if (trackMissing_) {
+        for (int i = 0; i < count; ++i) {
+            if (!present_.Get(indexes[i])) {
+                codes[i] = -1;
+            }
+        }
+    }
+}
+
+double FeatureColumn::SumPresent(int index, int count) const {
+    switch (type_) {
+        case UInt8Column:
+            return SumPresent(bytes_.GetData(), index, count);
+        case UInt16Column:
+            return SumPresent(shorts_.GetData(), index, count);
+        case BitColumn: {
+            int sum = 0;
+            for (int end = index + count; index < end; ) {
+                int bitCount;
+                uint64_t word = bits_.GetRangeWord(index, end, &bitCount);
+                if (trackMissing_) {
+                    word &= present_.GetRangeWord(index, end, &bitCount);
+                }
+                sum += PopCount(word);
+                index += bitCount;
+            }
+            return sum;
+        }
+        case FloatColumn:
+            return SumPresent(floats_.GetData(), index, count);
+        default:
+            return SumPresent(doubles_.GetData(), index, count);
+    }
+}
+
+template<typename T>
+double FeatureColumn::SumPresent(const T* values, int index, int count) const {
+    double sum = 0;
+    if (!trackMissing_) {
+        for (int i = index; i < index + count; ++i) {
+            sum += values[i];
+        }
+        return sum;
+    }
+    for (int end = index + count; index < end; ) {
+        int bitCount;
+        uint64_t word = present_.GetRangeWord(index, end, &bitCount);
+        if (PopCount(word) == bitCount) {
+            for (int i = index; i < index + bitCount; ++i) {
+                sum += values[i];
+            }
+        } else {
+            for (; word != 0; word &= word - 1) {
+                sum += values[index + CountTrailingZeros(word)];
+            }
+        }
+        index += bitCount;
+    }
+    return sum;
+}
+
+template<typename T>
+void FeatureColumn::GetValuesAs(int index, int count, T* values) const {
+    switch (type_) {
+        case UInt8Column:
+            std::copy(bytes_.GetData() + index, bytes_.GetData() + index + count, values);
+            break;
+        case UInt16Column:
+            std::copy(shorts_.GetData() + index, shorts_.GetData() + index + count, values);
+            break;
+        case BitColumn:
+            for (int i = 0; i < count; ++i) {
+                values[i] = bits_.Get(index + i);
+            }
+            break;
+        case FloatColumn:
+            std::copy(floats_.GetData() + index, floats_.GetData() + index + count, values);
+            return;
+        default:
+            std::copy(doubles_.GetData() + index, doubles_.GetData() + index + count, values);
+            return;
+    }
+    if (trackMissing_) {
+        for (int i = 0; i < count; ++i) {
+            if (!present_.Get(index + i)) {
+                values[i] = static_cast<T>(NaN);
+            }
+        }
+    }
+}
+
+template<typename T>
+void FeatureColumn::GatherValuesAs(const int* indexes, int count, T* values) const {
+    switch (type_) {
+        case UInt8Column:
+            GatherStored(bytes_.GetData(), indexes, count, values);
+            break;
+        case UInt16Column:
+            GatherStored(shorts_.GetData(), indexes, count, values);
+            break;
+        case BitColumn:
+            for (int i = 0; i < count; ++i) {
+                values[i] = bits_.Get(indexes[i]);
+            }
+            break;
+        case FloatColumn:
+            GatherStored(floats_.GetData(), indexes, count, values);
+            return;
+        default:
+            GatherStored(doubles_.GetData(), indexes, count, values);
+            return;
+    }
+    if (trackMissing_) {
+        for (int i = 0; i < count; ++i) {
+            if (!present_.Get(indexes[i])) {
+                values[i] = static_cast<T>(NaN);
+            }
+        }
+    }
+}
+
+template<typename TStored, typename T>
+void FeatureColumn::GatherStored(const TStored* data, const int* indexes, int count, T* values) {
+    for (int i = 0; i < count; ++i) {
+        values[i] = static_cast<T>(data[indexes[i]]);
+    }
+}
+
+ColumnType FeatureColumn::GetCompactType(FeatureType type, int nominalValueCount, bool singlePrecision) {
+    if (type == Binary) {
+        return BitColumn;
+    } else if (type == Nominal && nominalValueCount <= 0x100) {
+        return UInt8Column;
+    } else if (type == Nominal && nominalValueCount <= 0x10000) {
+        return UInt16Column;
+    } else if (type != Nominal && singlePrecision) {
+        return FloatColumn;
+    } else {
+        return DoubleColumn;
+    }
+}
+
+bool FeatureColumn::CanStore(ColumnType type, double value) {
+    if (type == DoubleColumn || IsNaN(value)) {
+        return true;
+    }
+    if (type == FloatColumn) {
+        // values are rounded, only the range is checked
+        return fabs(value) <= std::numeric_limits<float>::max() || fabs(value) == std::numeric_limits<double>::infinity();
+    }
+    // -0 is rejected too, integer codes would lose its sign
+    if (value < 0 || value != floor(value) || (value == 0 && std::signbit(value))) {
+        return false;
+    }
+    switch (type) {
+        case UInt8Column:
+            return value <= 0xFF;
+        case UInt16Column:
+            return value <= 0xFFFF;
+        case BitColumn:
+            return value <= 1;
+        default:
+            return true;
+    }
+}
+
+double FeatureColumn::GetStored(int index) const {
+    switch (type_) {
+        case UInt8Column:
+            return bytes_.Get(index);
+        case UInt16Column:
+            return shorts_.Get(index);
+        case BitColumn:
+            return bits_.Get(index);
+        case FloatColumn:
+            return floats_.Get(index);
+        default:
+            return doubles_.Get(index);
+    }
+}
+
+void FeatureColumn::SetStored(int index, double value) {
+    if (IsNaN(value) && !StoresNaN(type_)) {
+        value = 0;
+    }
+    switch (type_) {
+        case UInt8Column:
+            bytes_.Set(index, static_cast<uint8_t>(value));
+            break;
+        case UInt16Column:
+            shorts_.Set(index, static_cast<uint16_t>(value));
+            break;
+        case BitColumn:
+            bits_.Set(index, value != 0);
+            break;
+        case FloatColumn:
+            floats_.Set(index, static_cast<float>(value));
+            break;
+        default:
+            doubles_.Set(index, value);
+            break;
+    }
+}
+
+void FeatureColumn::PushBackStored(double value) {
+    if (IsNaN(value) && !StoresNaN(type_)) {
+        value = 0;
+    }
+    switch (type_) {
+        case UInt8Column:
+            bytes_.PushBack(static_cast<uint8_t>(value));
+            break;
+        case UInt16Column:
+            shorts_.PushBack(static_cast<uint16_t>(value));
+            break;
+        case BitColumn:
+            bits_.PushBack(value != 0);
+            break;
+        case FloatColumn:
+            floats_.PushBack(static_cast<float>(value));
+            break;
+        default:
+            doubles_.PushBack(value);
+            break;
+    }
+    ++size_;
+}
+
+} // namespace mll
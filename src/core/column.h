@@ -0,0 +1,245 @@
+#ifndef COLUMN_H_
+#define COLUMN_H_
+
+#include <stdint.h>
+
+#include "aligned_array.h"
+#include "bitmap.h"
+#include "data.h"
+
+namespace mll {
+
+//! Physical type of column values
+enum ColumnType {
+    DoubleColumn,   //!< 8-byte floating point values
+    UInt8Column,    //!< 1-byte unsigned integer codes
+    UInt16Column,   //!< 2-byte unsigned integer codes
+    BitColumn,      //!< Bit-packed 0/1 values
+    FloatColumn     //!< 4-byte floating point values (rounded)
+};
+
+//! Values of one feature for all objects of a dataset.
+/*! Values are kept in one contiguous aligned buffer, so a feature can be
+    scanned with unit stride. The buffer is typed: binary and nominal features
+    can be stored as bits or small integer codes (see GetCompactType), a value
+    which doesn't fit the type converts the column to doubles. Other features
+    can be stored as floats, values are rounded then.
+    Missed values are stored as NaN in floating point columns (0 in other ones), and
+    columns with missed values also keep a bitmap of present values, so missed
+    values can be tested and counted without loading the values.
+*/
+class FeatureColumn {
+public:
+    //! Creates empty column of the type
+    explicit FeatureColumn(ColumnType type = DoubleColumn)
+        : type_(type),
+          size_(0),
+          trackMissing_(false) {
+    }
+
+    //! Creates column of the given size filled with the value
+    explicit FeatureColumn(int size, double value = 0, ColumnType type = DoubleColumn)
+        : type_(type),
+          size_(0),
+          trackMissing_(false) {
+        Resize(size, value);
+    }
+
+    //! Physical type of the values
+    ColumnType GetType() const {
+        return type_;
+    }
+
+    //! Number of values in the column
+    int GetSize() const {
+        return size_;
+    }
+
+    //! Pointer to the first value of double column (NULL for other types)
+    const double* GetData() const {
+        return type_ == DoubleColumn ? doubles_.GetData() : NULL;
+    }
+
+    //! Pointer to the first value of double column (call UpdateMissing after writing missed values)
+    double* GetData() {
+        return type_ == DoubleColumn ? doubles_.GetData() : NULL;
+    }
+
+    //! Pointer to the first value of float column (NULL for other types)
+    const float* GetFloatData() const {
+        return type_ == FloatColumn ? floats_.GetData() : NULL;
+    }
+
+    //! Pointer to the stored values (elements of the column type or bitmap words)
+    const void* GetRawData() const;
+
+    //! Size of the stored values in bytes
+    size_t GetRawSize() const;
+
+    //! Gets the value with the index
+    double Get(int index) const {
+        switch (type_) {
+            case UInt8Column:
+                return IsPresent(index) ? bytes_.Get(index) : NaN;
+            case UInt16Column:
+                return IsPresent(index) ? shorts_.Get(index) : NaN;
+            case BitColumn:
+                return IsPresent(index) ? bits_.Get(index) : NaN;
+            case FloatColumn:
+                return floats_.Get(index);
+            default:
+                return doubles_.Get(index);
+        }
+    }
+
+    //! Gets the value with the index as integer code (-1 if the value is missed)
+    int GetCode(int index) const {
+        if (!IsPresent(index)) {
+            return -1;
+        }
+        switch (type_) {
+            case UInt8Column:
+                return bytes_.Get(index);
+            case UInt16Column:
+                return shorts_.Get(index);
+            case BitColumn:
+                return bits_.Get(index);
+            case FloatColumn:
+                return static_cast<int>(floats_.Get(index));
+            default:
+                return IsNaN(doubles_.Get(index)) ? -1 : static_cast<int>(doubles_.Get(index));
+        }
+    }
+
+    //! Returns false if the value with the index is missed
+    bool IsPresent(int index) const {
+        return !trackMissing_ || present_.Get(index);
+    }
+
+    //! Returns true if the column keeps bitmap of present values
+    bool TracksMissing() const {
+        return trackMissing_;
+    }
+
+    //! Bitmap of present values (empty if the column doesn't track missed values)
+    const Bitmap& GetPresent() const {
+        return present_;
+    }
+
+    //! Sets the value with the index
+    void Set(int index, double value);
+
+    //! Appends one value to the end
+    void PushBack(double value);
+
+    //! Appends all values of the column to the end
+    void Append(const FeatureColumn& column);
+
+    //! Resizes column filling new elements with the value
+    void Resize(int size, double value = 0);
+
+    //! Reserves memory for the number of values
+    void Reserve(int size);
+
+    //! Swaps two values
+    void Swap(int index1, int index2);
+
+    //! Moves value indexes[i] to position i for all i (indexes must be a permutation of the size)
+    void Permute(const int* indexes);
+
+    //! Removes all values (the type is kept)
+    void Clear();
+
+    //! Converts values to the type, returns false if some values can't be stored in it
+    bool ConvertTo(ColumnType type);
+
+    //! Refers to external values which must outlive the column (copied on write)
+    void SetExternal(const double* values, int size) {
+        SetExternal(DoubleColumn, values, size);
+    }
+
+    //! Refers to external values of the type which must outlive the column (copied on write)
+    void SetExternal(ColumnType type, const void* values, int size);
+
+    //! Refers to external bitmap of present values which must outlive the column
+    void SetExternalPresent(const uint64_t* words) {
+        present_.SetExternal(words, size_);
+        trackMissing_ = true;
+    }
+
+    //! Creates bitmap of present values (even if no values are missed)
+    void TrackMissing();
+
+    //! Updates bitmap of present values after the values were written directly
+    void UpdateMissing();
+
+    //! Gets count values starting from index
+    void GetValues(int index, int count, double* values) const;
+
+    //! Gets count values starting from index rounded to floats
+    void GetValues(int index, int count, float* values) const;
+
+    //! Gets the values with the listed indices
+    void GatherValues(const int* indexes, int count, double* values) const;
+
+    //! Gets the values with the listed indices rounded to floats
+    void GatherValues(const int* indexes, int count, float* values) const;
+
+    //! Gets count values starting from index as integer codes (-1 for missed values)
+    void GetCodes(int index, int count, int* codes) const;
+
+    //! Gets the values with the listed indices as integer codes (-1 for missed values)
+    void GatherCodes(const int* indexes, int count, int* codes) const;
+
+    //! Counts present values in the range [index, index + count)
+    int CountPresent(int index, int count) const {
+        return trackMissing_ ? present_.CountSetBits(index, count) : count;
+    }
+
+    //! Sums present values in the range [index, index + count) in order
+    double SumPresent(int index, int count) const;
+
+    //! Gets the smallest type which can store values of the feature (floats for non-nominal ones if singlePrecision)
+    static ColumnType GetCompactType(FeatureType type, int nominalValueCount, bool singlePrecision = false);
+
+    //! Returns true if the value can be stored in the column of the type
+    static bool CanStore(ColumnType type, double value);
+
+private:
+    //! Gets the stored value (no check for missed values)
+    double GetStored(int index) const;
+    //! Sets the stored value, which must fit the type
+    void SetStored(int index, double value);
+    //! Appends the stored value, which must fit the type
+    void PushBackStored(double value);
+    //! Sums present values of the array in the range [index, index + count)
+    template<typename T>
+    double SumPresent(const T* values, int index, int count) const;
+    //! Gets count values starting from index converted to T
+    template<typename T>
+    void GetValuesAs(int index, int count, T* values) const;
+    //! Gets the values with the listed indices converted to T
+    template<typename T>
+    void GatherValuesAs(const int* indexes, int count, T* values) const;
+    //! Gathers the stored values converting them to T
+    template<typename TStored, typename T>
+    static void GatherStored(const TStored* data, const int* indexes, int count, T* values);
+    //! Returns true if columns of the type store missed values as NaN
+    static bool StoresNaN(ColumnType type) {
+        return type == DoubleColumn || type == FloatColumn;
+    }
+
+    ColumnType type_;                   //!< Type of the values
+    int size_;                          //!< Number of values
+    AlignedArray<double> doubles_;      //!< Values of double column
+    AlignedArray<uint8_t> bytes_;       //!< Values of uint8 column
+    AlignedArray<uint16_t> shorts_;     //!< Values of uint16 column
+    Bitmap bits_;                       //!< Values of bit column
+    AlignedArray<float> floats_;        //!< Values of float column
+    Bitmap present_;                    //!< Bits of present values (if missed values are tracked)
+    bool trackMissing_;                 //!< If the bitmap of present values is kept
+};
+
+} // namespace mll
+
+#endif // COLUMN_H_
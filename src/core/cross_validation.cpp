@@ -1,6 +1,9 @@
 #include "cross_validation.h"
 
 #include "dataset_wrapper.h"
+#include "permutation.h"
+#include "random.h"
+#include "thread_pool.h"
 
 using std::vector;
 
@@ -11,80 +14,179 @@ REGISTER_TESTER(mll::LeaveOneOutTester, "LOO", "MLL", "Leave-one-out CV");
 
 namespace mll {
 
-double RandomTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
-    int testLength = static_cast<int>(dataSet->GetObjectCount() * testPortion_ + 1);
-    double errors = 0;
-    double testedWeightSum = 0;
-    vector<int> indexes;
-    InitIndexes(dataSet->GetObjectCount(), &indexes);
-    for (int i = 0; i < testCount_; ++i) {
-        dataSet->ShuffleObjects();
-        DataSetWrapper testSetWrapper(dataSet);
-        testSetWrapper.SetObjectIndexes(indexes.begin(), indexes.begin() + testLength);
-        DataSetWrapper trainSetWrapper(dataSet);
-        trainSetWrapper.SetObjectIndexes(indexes.begin() + testLength, indexes.end());
-        testedWeightSum += testSetWrapper.GetWeightSum();
-        errors += GetClassificationErrorSum(classifier, &trainSetWrapper, &testSetWrapper);
+namespace {
+
+//! Trains on the listed objects except the range [testBegin, testEnd) and tests on the range
+class FoldTask {
+public:
+    FoldTask(const IClassifier* classifier, IDataSet* dataSet,
+             sh_ptr< const vector<int> > indexes, int testBegin, int testEnd)
+        : classifier_(classifier),
+          dataSet_(dataSet),
+          indexes_(indexes),
+          testBegin_(testBegin),
+          testEnd_(testEnd),
+          errors_(0),
+          testedWeightSum_(0) {
     }
-    return testedWeightSum == 0 ? 0.0 : errors / testedWeightSum;
+
+    void Run() {
+        const vector<int>& indexes = *indexes_;
+        DataSetWrapper testSetWrapper(dataSet_);
+        testSetWrapper.SetObjectIndexes(indexes.begin() + testBegin_, indexes.begin() + testEnd_);
+        // the train list is built once and taken by the wrapper
+        sh_ptr< vector<int> > trainIndexes(new vector<int>());
+        trainIndexes->reserve(indexes.size() - (testEnd_ - testBegin_));
+        trainIndexes->insert(trainIndexes->end(), indexes.begin(), indexes.begin() + testBegin_);
+        trainIndexes->insert(trainIndexes->end(), indexes.begin() + testEnd_, indexes.end());
+        DataSetWrapper trainSetWrapper(dataSet_);
+        trainSetWrapper.SetObjectIndexes(trainIndexes);
+        testedWeightSum_ = testSetWrapper.GetWeightSum();
+        errors_ = GetClassificationErrorSum(*classifier_, &trainSetWrapper, &testSetWrapper);
+    }
+
+    //! Weighted sum of errors on the test objects
+    double GetErrors() const {
+        return errors_;
+    }
+
+    //! Sum of weights of the test objects
+    double GetTestedWeightSum() const {
+        return testedWeightSum_;
+    }
+
+private:
+    const IClassifier* classifier_;
+    IDataSet* dataSet_;
+    sh_ptr< const vector<int> > indexes_;
+    int testBegin_;
+    int testEnd_;
+    double errors_;
+    double testedWeightSum_;
+};
+
+//! Runs the range of fold tasks
+class FoldRunner {
+public:
+    explicit FoldRunner(vector<FoldTask>* tasks)
+        : tasks_(tasks) {
+    }
+
+    void operator() (int first, int last) const {
+        for (int i = first; i < last; ++i) {
+            tasks_->at(i).Run();
+        }
+    }
+
+private:
+    vector<FoldTask>* tasks_;
+};
+
+//! Runs the tasks on at most threadCount threads of the global pool (0 for all its threads)
+void RunFolds(vector<FoldTask>* tasks, int threadCount) {
+    ParallelForThreads(0, static_cast<int>(tasks->size()), FoldRunner(tasks), threadCount);
 }
 
-double QFoldTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
-    int foldLength = dataSet->GetObjectCount() / foldCount_;
-    int remainedObjects = dataSet->GetObjectCount() - foldCount_ * foldLength;
-    double errors = 0;
-    double weightSum = dataSet->GetWeightSum();
-    vector<int> indexes;
-    InitIndexes(dataSet->GetObjectCount(), &indexes);
+//! Adds tasks of q folds of the objects in the listed order
+/*! All folds share the list, each one tests its consecutive range of it.
+*/
+void AddQFoldTasks(const IClassifier& classifier, IDataSet* dataSet, sh_ptr< const vector<int> > indexes,
+                   int foldCount, vector<FoldTask>* tasks) {
+    int foldLength = static_cast<int>(indexes->size()) / foldCount;
+    int remainedObjects = static_cast<int>(indexes->size()) - foldCount * foldLength;
     int offset = 0;
-    for (int i = 0; i < foldCount_; ++i) {
+    for (int i = 0; i < foldCount; ++i) {
         int testLength = foldLength;
         if (remainedObjects > 0) {
             --remainedObjects;
             ++testLength;
         }
-        if (offset > 0) {
-            std::swap_ranges(
-                indexes.begin(),
-                indexes.begin() + testLength,
-                indexes.begin() + offset);
-        }
+        tasks->push_back(FoldTask(&classifier, dataSet, indexes, offset, offset + testLength));
         offset += testLength;
+    }
+}
+
+} // namespace
+
+double RandomTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
+    int testLength = static_cast<int>(dataSet->GetObjectCount() * testPortion_ + 1);
+    // the order of objects is changed by composing permutations, the dataset itself is not changed
+    Random random(seed_);
+    Permutation permutation(dataSet->GetObjectCount());
+    vector<FoldTask> tasks;
+    for (int i = 0; i < testCount_; ++i) {
+        Permutation shuffle(dataSet->GetObjectCount());
+        shuffle.Shuffle(&random);
+        permutation = permutation.Compose(shuffle);
+        sh_ptr< const vector<int> > indexes(new vector<int>(permutation.GetIndexes()));
+        tasks.push_back(FoldTask(&classifier, dataSet, indexes, 0, testLength));
+    }
+    RunFolds(&tasks, threadCount_);
+    // the results are summed in the order of the folds, so they don't depend on the threads
+    double errors = 0;
+    double testedWeightSum = 0;
+    for (int i = 0; i < static_cast<int>(tasks.size()); ++i) {
+        testedWeightSum += tasks[i].GetTestedWeightSum();
+        errors += tasks[i].GetErrors();
+    }
+    return testedWeightSum == 0 ? 0.0 : errors / testedWeightSum;
+}
 
-        DataSetWrapper testSetWrapper(dataSet);
-        testSetWrapper.SetObjectIndexes(indexes.begin(), indexes.begin() + testLength);
-        DataSetWrapper trainSetWrapper(dataSet);
-        trainSetWrapper.SetObjectIndexes(indexes.begin() + testLength, indexes.end());
-        errors += GetClassificationErrorSum(classifier, &trainSetWrapper, &testSetWrapper);
+double QFoldTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
+    double weightSum = dataSet->GetWeightSum();
+    vector<int>* indexes = new vector<int>();
+    sh_ptr< const vector<int> > sharedIndexes(indexes);
+    InitIndexes(dataSet->GetObjectCount(), indexes);
+    vector<FoldTask> tasks;
+    AddQFoldTasks(classifier, dataSet, sharedIndexes, foldCount_, &tasks);
+    RunFolds(&tasks, threadCount_);
+    double errors = 0;
+    for (int i = 0; i < static_cast<int>(tasks.size()); ++i) {
+        errors += tasks[i].GetErrors();
     }
     return errors / weightSum;
 }
 
 double TQFoldTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
+    double weightSum = dataSet->GetWeightSum();
+    // folds of all tests are run at once
+    Random random(seed_);
+    Permutation permutation(dataSet->GetObjectCount());
+    vector<FoldTask> tasks;
+    for (int i = 0; i < testCount_; ++i) {
+        Permutation shuffle(dataSet->GetObjectCount());
+        shuffle.Shuffle(&random);
+        permutation = permutation.Compose(shuffle);
+        // one list per test is shared by its folds
+        sh_ptr< const vector<int> > indexes(new vector<int>(permutation.GetIndexes()));
+        AddQFoldTasks(classifier, dataSet, indexes, foldCount_, &tasks);
+    }
+    RunFolds(&tasks, threadCount_);
     double errors = 0;
-    QFoldTester tester;
-    tester.SetFoldCount(foldCount_);
     for (int i = 0; i < testCount_; ++i) {
-        dataSet->ShuffleObjects();
-        errors += tester.Test(classifier, dataSet) / testCount_;
+        double testErrors = 0;
+        for (int j = 0; j < foldCount_; ++j) {
+            testErrors += tasks[i * foldCount_ + j].GetErrors();
+        }
+        errors += testErrors / weightSum / testCount_;
     }
     return errors;
 }
 
 double LeaveOneOutTester::Test(const IClassifier& classifier, IDataSet* dataSet) const {
-    double errors = 0;
     double weightSum = dataSet->GetWeightSum();
-    vector<int> indexes;
-    InitIndexes(dataSet->GetObjectCount(), &indexes);
-    DataSetWrapper testSetWrapper(dataSet);
-    testSetWrapper.SetObjectIndexes(indexes.begin(), indexes.begin() + 1);
-    DataSetWrapper trainSetWrapper(dataSet);
-    trainSetWrapper.SetObjectIndexes(indexes.begin() + 1, indexes.end());
+    // all folds share one list: the object i is tested, the others are trained in their order
+    vector<int>* indexes = new vector<int>();
+    sh_ptr< const vector<int> > sharedIndexes(indexes);
+    InitIndexes(dataSet->GetObjectCount(), indexes);
+    vector<FoldTask> tasks;
     for (int i = 0; i < dataSet->GetObjectCount(); ++i) {
-        if (i > 0) {
-            dataSet->SwapObjects(0, i);
-        }
-        errors += GetClassificationErrorSum(classifier, &trainSetWrapper, &testSetWrapper);
+        tasks.push_back(FoldTask(&classifier, dataSet, sharedIndexes, i, i + 1));
+    }
+    RunFolds(&tasks, threadCount_);
+    double errors = 0;
+    for (int i = 0; i < static_cast<int>(tasks.size()); ++i) {
+        errors += tasks[i].GetErrors();
     }
     return errors / weightSum;
 }
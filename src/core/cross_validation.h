@@ -15,11 +15,17 @@ public:
     //! Default initialization
     RandomTester()
         : testCount_(10),
-          testPortion_(0.3) {
+          testPortion_(0.3),
+          seed_(0),
+          threadCount_(1) {
         AddParameter("t", testCount_, &RandomTester::GetTestCount, &RandomTester::SetTestCount,
                      "Number of tests");
         AddParameter("r", testPortion_, &RandomTester::GetTestPortion, &RandomTester::SetTestPortion,
                      "Portion of objects left in test set");
+        AddParameter("s", seed_, &RandomTester::GetSeed, &RandomTester::SetSeed,
+                     "Seed of random shuffles");
+        AddParameter("j", threadCount_, &RandomTester::GetThreadCount, &RandomTester::SetThreadCount,
+                     "Number of threads of the global pool to run folds (0 for all)");
     }
 
 
@@ -53,9 +59,33 @@ public:
         }
     }
 
+    //! Seed of random shuffles
+    int GetSeed() const {
+        return seed_;
+    }
+
+    //! Sets seed of random shuffles, the same seed gives the same folds
+    void SetSeed(int seed) {
+        seed_ = seed;
+    }
+
+    //! Number of threads of the global pool to run the folds (0 for all)
+    int GetThreadCount() const {
+        return threadCount_;
+    }
+
+    //! Sets number of threads to run the folds, the result doesn't depend on it
+    void SetThreadCount(int threadCount) {
+        if (threadCount >= 0) {
+            threadCount_ = threadCount;
+        }
+    }
+
 private:
     int testCount_;         //!< Number of tests
     double testPortion_;    //!< Portion of objects left in test set
+    int seed_;              //!< Seed of random shuffles
+    int threadCount_;       //!< Number of threads to run the folds
 };
 
 //! q-fold cross-validation tester
@@ -64,9 +94,12 @@ class QFoldTester: public Tester<QFoldTester> {
 public:
     //! Default initialization
     QFoldTester()
-        : foldCount_(10) {
+        : foldCount_(10),
+          threadCount_(1) {
         AddParameter("q", foldCount_, &QFoldTester::GetFoldCount, &QFoldTester::SetFoldCount,
                      "Number of folds (parameter 'q')");
+        AddParameter("j", threadCount_, &QFoldTester::GetThreadCount, &QFoldTester::SetThreadCount,
+                     "Number of threads of the global pool to run folds (0 for all)");
     }
 
     /*! Calculate average error of classification by a classifier created by
@@ -87,8 +120,21 @@ public:
         }
     }
 
+    //! Number of threads of the global pool to run the folds (0 for all)
+    int GetThreadCount() const {
+        return threadCount_;
+    }
+
+    //! Sets number of threads to run the folds, the result doesn't depend on it
+    void SetThreadCount(int threadCount) {
+        if (threadCount >= 0) {
+            threadCount_ = threadCount;
+        }
+    }
+
 private:
     int foldCount_;     //!< Number of folds
+    int threadCount_;   //!< Number of threads to run the folds
 };
 
 //! t*q-fold cross-validation tester
@@ -98,11 +144,17 @@ public:
     //! Default initialization
     TQFoldTester()
         : foldCount_(10),
-          testCount_(10) {
+          testCount_(10),
+          seed_(0),
+          threadCount_(1) {
         AddParameter("q", foldCount_, &TQFoldTester::GetFoldCount, &TQFoldTester::SetFoldCount,
                      "Number of folds (parameter 'q')");
         AddParameter("t", testCount_, &TQFoldTester::GetTestCount, &TQFoldTester::SetTestCount,
                      "Number of tests");
+        AddParameter("s", seed_, &TQFoldTester::GetSeed, &TQFoldTester::SetSeed,
+                     "Seed of random shuffles");
+        AddParameter("j", threadCount_, &TQFoldTester::GetThreadCount, &TQFoldTester::SetThreadCount,
+                     "Number of threads of the global pool to run folds (0 for all)");
     }
 
     /*! Calculate average error of classification by a classifier created by
@@ -135,20 +187,66 @@ public:
         }
     }
 
+    //! Seed of random shuffles
+    int GetSeed() const {
+        return seed_;
+    }
+
+    //! Sets seed of random shuffles, the same seed gives the same folds
+    void SetSeed(int seed) {
+        seed_ = seed;
+    }
+
+    //! Number of threads of the global pool to run the folds (0 for all)
+    int GetThreadCount() const {
+        return threadCount_;
+    }
+
+    //! Sets number of threads to run the folds, the result doesn't depend on it
+    void SetThreadCount(int threadCount) {
+        if (threadCount >= 0) {
+            threadCount_ = threadCount;
+        }
+    }
+
 private:
     int foldCount_;     //!< Number of folds
     int testCount_;     //!< Number of tests
+    int seed_;          //!< Seed of random shuffles
+    int threadCount_;   //!< Number of threads to run the folds
 };
 
 //! Leave-one-out cross-validation tester
 class LeaveOneOutTester: public Tester<LeaveOneOutTester> {
 	DECLARE_REGISTRATION();
 public:
+    //! Default initialization
+    LeaveOneOutTester()
+        : threadCount_(1) {
+        AddParameter("j", threadCount_, &LeaveOneOutTester::GetThreadCount, &LeaveOneOutTester::SetThreadCount,
+                     "Number of threads of the global pool to run folds (0 for all)");
+    }
+
     /*! Calculate average error of classification by a classifier created by
         the classifier factory using the data set
     */
     virtual double Test(const IClassifier& classifier,
                         IDataSet* dataSet) const;
+
+    //! Number of threads of the global pool to run the folds (0 for all)
+    int GetThreadCount() const {
+        return threadCount_;
+    }
+
+    //! Sets number of threads to run the folds, the result doesn't depend on it
+    void SetThreadCount(int threadCount) {
+        if (threadCount >= 0) {
+            threadCount_ = threadCount;
+        }
+    }
+
+private:
+    int threadCount_;   //!< Number of threads to run the folds
 };
 
 } // namespace mll
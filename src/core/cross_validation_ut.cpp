@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include "cross_validation.h"
+#include "dataset.h"
+#include "dataset_wrapper.h"
+#include "thread_pool.h"
+
+using namespace mll;
+
+class CrossValidationTest : public testing::Test {
+protected:
+	//! Runs the tester with serial and parallel folds, the errors must be the same
+	static void TestThreads(ITester* tester, IDataSet* dataSet) {
+		sh_ptr<IClassifier> classifier = ClassifierFactory::Instance().Create("DecisionStump");
+		ASSERT_TRUE(classifier.get() != NULL);
+		ASSERT_TRUE(tester->SetParameter("j", "1"));
+		double serialError = tester->Test(*classifier, dataSet);
+		ASSERT_TRUE(tester->SetParameter("j", "4"));
+		double parallelError = tester->Test(*classifier, dataSet);
+		ASSERT_EQ(serialError, parallelError);
+		ASSERT_LT(0.0, serialError);
+	}
+};
+
+TEST_F(CrossValidationTest, ParallelFoldsTest)
+{
+	const int OBJECTS = 120;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 3);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, (i * 37) % 101);
+		dataSet.SetFeature(i, 1, i % 11 == 0 ? NaN : (i * 13) % 17);
+		dataSet.SetFeature(i, 2, i % 3);
+		dataSet.SetTarget(i, (i * 37) % 101 + i % 3 * 20 > 60);
+		dataSet.SetWeight(i, 1.0 + i % 4);
+	}
+
+	ThreadPool::SetGlobalThreadCount(4);
+	RandomTester randomTester;
+	ASSERT_TRUE(randomTester.SetParameter("s", "7"));
+	TestThreads(&randomTester, &dataSet);
+	QFoldTester qFoldTester;
+	TestThreads(&qFoldTester, &dataSet);
+	TQFoldTester tqFoldTester;
+	TestThreads(&tqFoldTester, &dataSet);
+	LeaveOneOutTester leaveOneOutTester;
+	TestThreads(&leaveOneOutTester, &dataSet);
+
+	// folds of wrapped data are read from a snapshot
+	DataSetWrapper wrapper(&dataSet);
+	wrapper.SetWeight(0, 10.0);
+	wrapper.Reverse();
+	TestThreads(&qFoldTester, &wrapper);
+	ASSERT_EQ("4", qFoldTester.GetParameter("j"));
+	ASSERT_FALSE(qFoldTester.SetParameter("unknown", "1"));
+	ThreadPool::SetGlobalThreadCount(0);
+}
@@ -32,138 +32,189 @@ inline int IDataSet::GetClassCount() const {
     return GetMetaData().GetClassCount();
 }
 
-inline double IDataSet::GetWeightSum() const {
-    double weightSum = 0;
-    for (int i = 0; i < GetObjectCount(); ++i) {
-        weightSum += GetWeight(i);
+inline void IDataSet::GetFeatures(int featureIndex, int objectIndex, int count, double* features) const {
+    for (int i = 0; i < count; ++i) {
+        features[i] = GetFeature(objectIndex + i, featureIndex);
     }
-    return weightSum;
 }
 
-inline void IDataSet::NormalizeWeights() {
-    double weightSum = 0;
-    for (int i = 0; i < GetObjectCount(); ++i) {
-        weightSum += GetWeight(i);
-    }
-    if (weightSum == 0) {
-        return;
+inline void IDataSet::GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const {
+    for (int i = 0; i < count; ++i) {
+        features[i] = GetFeature(objectIndexes[i], featureIndex);
     }
-    for (int i = 0; i < GetObjectCount(); ++i) {
-        SetWeight(i, GetWeight(i) / weightSum);
+}
+
+inline void IDataSet::GetTargets(int objectIndex, int count, int* targets) const {
+    for (int i = 0; i < count; ++i) {
+        targets[i] = GetTarget(objectIndex + i);
     }
 }
 
-inline void IDataSet::ShuffleObjects() {
-    std::vector<int> indexes;
-    InitIndexes(GetObjectCount(), &indexes);
-    std::random_shuffle(indexes.begin(), indexes.end());
-    for (int i = 0; i < static_cast<int>(indexes.size()); ++i) {
-        int index = indexes[i];
-        while (index < i) {
-            indexes[i] = index = indexes[index];
-        }
-        SwapObjects(i, index);
+inline void IDataSet::GatherTargets(const int* objectIndexes, int count, int* targets) const {
+    for (int i = 0; i < count; ++i) {
+        targets[i] = GetTarget(objectIndexes[i]);
     }
 }
 
-inline void IDataSet::Reverse() {
-    for (int i = 0, j = GetObjectCount() - 1; i < j; ++i, --j) {
-        SwapObjects(i, j);
+inline void IDataSet::GetWeights(int objectIndex, int count, double* weights) const {
+    for (int i = 0; i < count; ++i) {
+        weights[i] = GetWeight(objectIndex + i);
     }
 }
 
-template<typename TPredicate>
-inline void IDataSet::SortObjects(TPredicate predicate) {
-    std::vector<int> indexes;
-    InitIndexes(GetObjectCount(), &indexes);
-    std::sort(indexes.begin(), indexes.end(), predicate);
-    for (int i = 0; i < static_cast<int>(indexes.size()); ++i) {
-        int index = indexes[i];
-        while (index < i) {
-            indexes[i] = index = indexes[index];
-        }
-        SwapObjects(i, index);
+inline void IDataSet::GatherWeights(const int* objectIndexes, int count, double* weights) const {
+    for (int i = 0; i < count; ++i) {
+        weights[i] = GetWeight(objectIndexes[i]);
     }
 }
 
-class FeatureComparator {
-private:
-    const IDataSet& dataSet_;
-    int featureIndex_;
-    bool reverse_;
+inline void IDataSet::GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const {
+    for (int i = 0; i < count; ++i) {
+        features[i] = static_cast<float>(GetFeature(objectIndex + i, featureIndex));
+    }
+}
 
-public:
-    FeatureComparator(const IDataSet& dataSet, int featureIndex, bool reverse)
-        : dataSet_(dataSet),
-          featureIndex_(featureIndex),
-          reverse_(reverse) {
+inline void IDataSet::GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const {
+    for (int i = 0; i < count; ++i) {
+        features[i] = static_cast<float>(GetFeature(objectIndexes[i], featureIndex));
     }
+}
 
-    bool operator() (int objectIndex1, int objectIndex2) const {
-        if (reverse_) {
-            return dataSet_.GetFeature(objectIndex1, featureIndex_) >
-                   dataSet_.GetFeature(objectIndex2, featureIndex_);
-        } else {
-            return dataSet_.GetFeature(objectIndex1, featureIndex_) <
-                   dataSet_.GetFeature(objectIndex2, featureIndex_);
-        }
+inline void IDataSet::GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const {
+    for (int i = 0; i < count; ++i) {
+        codes[i] = HasFeature(objectIndex + i, featureIndex)
+            ? static_cast<int>(GetFeature(objectIndex + i, featureIndex))
+            : -1;
     }
-};
+}
 
-class WeightComparator {
-private:
-    const IDataSet& dataSet_;
-    bool reverse_;
+inline void IDataSet::GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const {
+    for (int i = 0; i < count; ++i) {
+        codes[i] = HasFeature(objectIndexes[i], featureIndex)
+            ? static_cast<int>(GetFeature(objectIndexes[i], featureIndex))
+            : -1;
+    }
+}
 
-public:
-    WeightComparator(const IDataSet& dataSet, bool reverse)
-        : dataSet_(dataSet),
-          reverse_(reverse) {
+inline int IDataSet::CountPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    int presentCount = 0;
+    for (int i = 0; i < count; ++i) {
+        presentCount += HasFeature(objectIndex + i, featureIndex);
     }
+    return presentCount;
+}
 
-    bool operator() (int objectIndex1, int objectIndex2) const {
-        if (reverse_) {
-            return dataSet_.GetWeight(objectIndex1) >
-                   dataSet_.GetWeight(objectIndex2);
-        } else {
-            return dataSet_.GetWeight(objectIndex1) <
-                   dataSet_.GetWeight(objectIndex2);
+inline double IDataSet::SumPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    double sum = 0;
+    for (int i = 0; i < count; ++i) {
+        if (HasFeature(objectIndex + i, featureIndex)) {
+            sum += GetFeature(objectIndex + i, featureIndex);
         }
     }
-};
+    return sum;
+}
 
-class TargetComparator {
-private:
-    const IDataSet& dataSet_;
-    bool reverse_;
+inline sh_ptr< const std::vector<int> > IDataSet::GetSortedObjectIndexes(int featureIndex) const {
+    std::vector<double> features(GetObjectCount());
+    if (!features.empty()) {
+        GetFeatures(featureIndex, 0, GetObjectCount(), &features[0]);
+    }
+    // stable sorting of the identity breaks ties by index
+    Permutation permutation(GetObjectCount());
+    permutation.SortByKeys(features.empty() ? NULL : &features[0]);
+    return sh_ptr< const std::vector<int> >(new std::vector<int>(permutation.GetIndexes()));
+}
 
-public:
-    TargetComparator(const IDataSet& dataSet, bool reverse)
-        : dataSet_(dataSet),
-          reverse_(reverse) {
+inline double IDataSet::GetWeightSum() const {
+    const int BlockSize = 1024;
+    double weights[BlockSize];
+    double weightSum = 0;
+    for (int first = 0; first < GetObjectCount(); first += BlockSize) {
+        int count = std::min(BlockSize, GetObjectCount() - first);
+        GetWeights(first, count, weights);
+        for (int i = 0; i < count; ++i) {
+            weightSum += weights[i];
+        }
     }
+    return weightSum;
+}
 
-    bool operator() (int objectIndex1, int objectIndex2) const {
-        if (reverse_) {
-            return dataSet_.GetTarget(objectIndex1) >
-                   dataSet_.GetTarget(objectIndex2);
-        } else {
-            return dataSet_.GetTarget(objectIndex1) <
-                   dataSet_.GetTarget(objectIndex2);
+inline void IDataSet::NormalizeWeights() {
+    double weightSum = GetWeightSum();
+    if (weightSum == 0) {
+        return;
+    }
+    for (int i = 0; i < GetObjectCount(); ++i) {
+        SetWeight(i, GetWeight(i) / weightSum);
+    }
+}
+
+inline void IDataSet::ApplyPermutation(const Permutation& permutation) {
+    if (permutation.GetSize() != GetObjectCount()) {
+        throw std::invalid_argument("Permutation size doesn't match the number of objects");
+    }
+    std::vector<int> indexes(permutation.GetIndexes());
+    for (int i = 0; i < static_cast<int>(indexes.size()); ++i) {
+        int index = indexes[i];
+        while (index < i) {
+            indexes[i] = index = indexes[index];
         }
+        SwapObjects(i, index);
     }
-};
+}
+
+inline void IDataSet::ShuffleObjects(Random* random) {
+    Permutation permutation(GetObjectCount());
+    permutation.Shuffle(random);
+    ApplyPermutation(permutation);
+}
+
+inline void IDataSet::Reverse() {
+    Permutation permutation(GetObjectCount());
+    permutation.Reverse();
+    ApplyPermutation(permutation);
+}
+
+template<typename TPredicate>
+inline void IDataSet::SortObjects(TPredicate predicate) {
+    Permutation permutation(GetObjectCount());
+    permutation.Sort(predicate);
+    ApplyPermutation(permutation);
+}
 
 inline void IDataSet::SortObjectsByFeature(int featureIndex, bool reverse) {
-    SortObjects(FeatureComparator(*this, featureIndex, reverse));
+    std::vector<double> features(GetObjectCount());
+    if (!features.empty()) {
+        GetFeatures(featureIndex, 0, GetObjectCount(), &features[0]);
+    }
+    Permutation permutation(GetObjectCount());
+    permutation.SortByKeys(features.empty() ? NULL : &features[0], reverse);
+    ApplyPermutation(permutation);
 }
 
 inline void IDataSet::SortObjectsByWeight(bool reverse) {
-    SortObjects(WeightComparator(*this, reverse));
+    std::vector<double> weights(GetObjectCount());
+    if (!weights.empty()) {
+        GetWeights(0, GetObjectCount(), &weights[0]);
+    }
+    Permutation permutation(GetObjectCount());
+    permutation.SortByKeys(weights.empty() ? NULL : &weights[0], reverse);
+    ApplyPermutation(permutation);
 }
 
 inline void IDataSet::SortObjectsByTarget(bool reverse) {
-    SortObjects(TargetComparator(*this, reverse));
+    std::vector<int> targets(GetObjectCount());
+    if (!targets.empty()) {
+        GetTargets(0, GetObjectCount(), &targets[0]);
+    }
+    // targets of datasets without class names aren't limited by the class count
+    int classCount = GetClassCount();
+    for (int i = 0; i < static_cast<int>(targets.size()); ++i) {
+        classCount = std::max(classCount, targets[i] + 1);
+    }
+    Permutation permutation(GetObjectCount());
+    permutation.SortByCodes(targets.empty() ? NULL : &targets[0], classCount, reverse);
+    ApplyPermutation(permutation);
 }
 
 } // namespace mll
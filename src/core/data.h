@@ -3,9 +3,12 @@
 
 #include <algorithm>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "permutation.h"
+#include "random.h"
 #include "sh_ptr.h"
 #include "util.h"
 
@@ -65,7 +68,10 @@ public:
     virtual double GetPenalty(int actualClass, int predictedClass) const = 0;
 
     //! Number of classes (nominal values of the target feature)
-    int GetClassCount() const;
+    /*! Called for every written target, so implementations count the classes
+        without copying the target feature's metadata.
+    */
+    virtual int GetClassCount() const;
     //! If classification refusal is allowable
     bool AllowRefuse() const;
 
@@ -75,6 +81,10 @@ public:
 };
 
 //! Dataset interface
+/*! Const methods of datasets can be called by any number of threads at once
+    while nobody changes the data. Changing methods need exclusive access to
+    the dataset and to the wrappers built on it.
+*/
 class IDataSet {
 public:
     //! Gets metadata about the dataset
@@ -93,6 +103,39 @@ public:
     virtual bool HasConfidences() const = 0;
     //! Gets the object classification confidence for the target
     virtual double GetConfidence(int objectIndex, int target) const = 0;
+
+    //! Gets the feature values of count objects starting from objectIndex
+    virtual void GetFeatures(int featureIndex, int objectIndex, int count, double* features) const;
+    //! Gets the feature values of the listed objects
+    virtual void GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const;
+    //! Gets the targets of count objects starting from objectIndex
+    virtual void GetTargets(int objectIndex, int count, int* targets) const;
+    //! Gets the targets of the listed objects
+    virtual void GatherTargets(const int* objectIndexes, int count, int* targets) const;
+    //! Gets the weights of count objects starting from objectIndex
+    virtual void GetWeights(int objectIndex, int count, double* weights) const;
+    //! Gets the weights of the listed objects
+    virtual void GatherWeights(const int* objectIndexes, int count, double* weights) const;
+    //! Gets the feature values of count objects starting from objectIndex as floats
+    virtual void GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const;
+    //! Gets the feature values of the listed objects as floats
+    virtual void GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const;
+    //! Gets the feature values of count objects starting from objectIndex as integer codes
+    /*! Useful for nominal and binary features: missed values are -1, others are truncated to int.
+    */
+    virtual void GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const;
+    //! Gets the feature values of the listed objects as integer codes (-1 for missed values)
+    virtual void GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const;
+    //! Counts objects which have the feature value among count objects starting from objectIndex
+    virtual int CountPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Sums present feature values of count objects starting from objectIndex
+    virtual double SumPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Gets indices of all objects ordered by the feature value (ascending, missed values last)
+    /*! The order of objects with equal values is deterministic but unspecified.
+        Datasets can cache the order, so it's cheap to call it for every learning;
+        the returned list is not updated when the data is changed.
+    */
+    virtual sh_ptr< const std::vector<int> > GetSortedObjectIndexes(int featureIndex) const;
     
     //! Gets data name
     const std::string& GetName() const;
@@ -118,18 +161,20 @@ public:
 
     //! Swaps two objects
     virtual void SwapObjects(int objectIndex1, int objectIndex2) = 0;
-    //! Randomly shuffles objects
-    void ShuffleObjects();
+    //! Moves object permutation.Get(i) to position i for all i (throws if the size doesn't match)
+    virtual void ApplyPermutation(const Permutation& permutation);
+    //! Randomly shuffles objects drawing numbers from the generator
+    void ShuffleObjects(Random* random);
     //! Reverses the order of all objects
     void Reverse();
     //! Sorts all objects by predicate
     template<typename TPredicate>
     void SortObjects(TPredicate predicate);
-    //! Sorts all objects by the feature value (ascending or descending)
+    //! Sorts all objects by the feature value (ascending or descending, missed values are the last, stable)
     void SortObjectsByFeature(int featureIndex, bool reverse = false);
-    //! Sorts all objects by weight (ascending or descending)
+    //! Sorts all objects by weight (ascending or descending, stable)
     void SortObjectsByWeight(bool reverse = false);
-    //! Sorts all objects by the target feature value (ascending or descending)
+    //! Sorts all objects by the target feature value (ascending or descending, stable)
     void SortObjectsByTarget(bool reverse = false);
 
     //! Destructor
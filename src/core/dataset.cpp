@@ -1,9 +1,17 @@
 #include <algorithm>
+#include <cstring>
 #include <limits>
 #include <fstream>
 #include <math.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
 
 #include "dataset.h"
+#include "arff_parser.h"
+#include "logger.h"
+#include "sparse_dataset.h"
+#include "thread_pool.h"
 #include "util.h"
 
 using std::string;
@@ -13,99 +21,131 @@ namespace mll {
 
 namespace {
 
-class Tokenizer {
-public:
-    Tokenizer(const string& data)
-        : data_(data),
-          position_(0) {
-        SkipWhiteSpaces();
+/*! Binary data file format (.mllb). Numbers are stored in the native byte order.
+    - header: magic, version, byte order mark, object and feature counts;
+    - metadata: strings are stored as length followed by characters,
+      penalties are stored as matrix of classCount x (classCount + 1),
+      each feature has ColumnType of its values section (since version 2);
+    - section table: offsets of targets, weights and feature values sections
+      followed by offsets of missing-values bitmaps (0 if the feature can't be missed);
+    - sections, each one is aligned by DefaultAlignment.
+    Bit i of a bitmap is set if the value of object i is present, bitmaps are
+    mapped as they are to the columns bitmaps of present values.
+*/
+const char BinaryMagic[4] = {'M', 'L', 'L', 'B'};
+const uint32_t BinaryVersion = 2;
+const uint32_t ByteOrderMark = 0x01020304;
+
+//! Dense copies of sparse data may hold this many cells per stored (nonzero) value
+const int64_t MaxDenseCellsPerValue = 64;
+//! Dense copies of sparse data may always hold this many cells
+const int64_t MinDenseCellLimit = 1 << 24;
+
+size_t AlignOffset(size_t offset) {
+    return (offset + DefaultAlignment - 1) / DefaultAlignment * DefaultAlignment;
+}
+
+size_t GetBitmapSize(int objectCount) {
+    return (objectCount + 63) / 64 * sizeof(uint64_t);
+}
+
+size_t GetColumnSize(ColumnType type, int objectCount) {
+    switch (type) {
+        case UInt8Column:
+            return objectCount * sizeof(uint8_t);
+        case UInt16Column:
+            return objectCount * sizeof(uint16_t);
+        case BitColumn:
+            return GetBitmapSize(objectCount);
+        case FloatColumn:
+            return objectCount * sizeof(float);
+        default:
+            return objectCount * sizeof(double);
     }
+}
 
+class BinaryWriter {
+public:
     const string& GetData() const {
         return data_;
     }
 
-    int GetPosition() const {
-        return position_;
+    template<typename T>
+    void Write(T value) {
+        data_.append(reinterpret_cast<const char*>(&value), sizeof(value));
     }
 
-    void SetPosition(int position) {
-        if (position >= 0) {
-            position_ = position;
-        }
+    void WriteString(const string& value) {
+        Write<uint32_t>(value.length());
+        data_.append(value);
     }
 
-    const string& GetCurrentToken() const {
-        return currentToken_;
+    void WriteStrings(const vector<string>& values) {
+        Write<uint32_t>(values.size());
+        for (vector<string>::const_iterator it = values.begin(); it != values.end(); ++it) {
+            WriteString(*it);
+        }
     }
 
-    template<typename T>
-    T GetCurrent() {
-        return mll::FromString<T>(currentToken_);
-    }
+private:
+    string data_;
+};
 
-    vector<char>& GetQuotes() {
-        return quotes_;
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size)
+        : data_(data),
+          size_(size),
+          position_(0) {
     }
 
-    const vector<char>& GetQuotes() const {
-        return quotes_;
+    size_t GetPosition() const {
+        return position_;
     }
 
-    vector<char>& GetDelimeters() {
-        return delimiters_;
+    template<typename T>
+    bool Read(T* value) {
+        if (size_ - position_ < sizeof(T)) {
+            return false;
+        }
+        memcpy(value, data_ + position_, sizeof(T));
+        position_ += sizeof(T);
+        return true;
     }
 
-    const vector<char>& GetDelimeters() const {
-        return delimiters_;
+    bool ReadString(string* value) {
+        uint32_t length;
+        if (!Read(&length) || size_ - position_ < length) {
+            return false;
+        }
+        value->assign(data_ + position_, length);
+        position_ += length;
+        return true;
     }
 
-    bool ReadNext() {
-        SkipWhiteSpaces();
-        if (position_ == data_.length()) {
+    bool ReadStrings(vector<string>* values) {
+        uint32_t count;
+        if (!Read(&count) || size_ - position_ < count) {
             return false;
         }
-        int length = 0;
-        int skip;
-        if (std::find(quotes_.begin(), quotes_.end(), data_[position_]) != quotes_.end()) {
-            ++position_;
-            while (position_ + length < static_cast<int>(data_.length()) && 
-                   std::find(quotes_.begin(), quotes_.end(), data_[position_ + length]) == quotes_.end()) {
-                ++length;
-            }
-            skip = length + 1;
-        } else {
-            while (position_ + length < static_cast<int>(data_.length()) && 
-                   std::find(delimiters_.begin(), delimiters_.end(), data_[position_ + length]) == delimiters_.end() && 
-                   !isspace(data_[position_ + length])) {
-                ++length;
+        values->resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            if (!ReadString(&values->at(i))) {
+                return false;
             }
-            skip = length;
-        }
-        currentToken_ = data_.substr(position_, length);
-        position_ += skip;
-        SkipWhiteSpaces();
-        if (position_ < static_cast<int>(data_.length()) && 
-            std::find(delimiters_.begin(), delimiters_.end(), data_[position_]) != delimiters_.end())
-        {
-            ++position_;
         }
         return true;
     }
 
-
-private:
-    void SkipWhiteSpaces() {
-        while (position_ < static_cast<int>(data_.length()) && isspace(data_[position_])) {
-            ++position_;
-        }
+    //! Checks that the section lies inside the data and is aligned
+    bool CheckSection(uint64_t offset, uint64_t size) const {
+        return offset % DefaultAlignment == 0 && offset <= size_ && size <= size_ - offset;
     }
 
-    string data_;
-    int position_;
-    vector<char> delimiters_;
-    vector<char> quotes_;
-    string currentToken_;
+private:
+    const char* data_;
+    size_t size_;
+    size_t position_;
 };
 
 } // namespace
@@ -115,205 +155,636 @@ DataSet::DataSet(const IDataSet& dataSet)
       objectCount_(dataSet.GetObjectCount()),
       targets_(dataSet.GetObjectCount()),
       weights_(dataSet.GetObjectCount()),
-      features_(dataSet.GetObjectCount(), vector<double>(dataSet.GetFeatureCount())) {
-    for (int i = 0; i < objectCount_; ++i) {
-        targets_.at(i) = dataSet.GetTarget(i);
-        weights_.at(i) = dataSet.GetWeight(i);
-        for (int j = 0; j < GetFeatureCount(); ++j) {
-            features_.at(i).at(j) = dataSet.GetFeature(i, j);
+      isSortedIndexesComplete_(false),
+      singlePrecision_(DefaultSinglePrecision) {
+    if (objectCount_ > 0) {
+        dataSet.GetTargets(0, objectCount_, targets_.GetData());
+        dataSet.GetWeights(0, objectCount_, weights_.GetData());
+    }
+    CreateColumns();
+    vector<double> features(objectCount_);
+    for (int j = 0; j < GetFeatureCount(); ++j) {
+        if (objectCount_ > 0) {
+            dataSet.GetFeatures(j, 0, objectCount_, &features[0]);
+        }
+        for (int i = 0; i < objectCount_; ++i) {
+            features_[j].Set(i, features[i]);
+        }
+        if (features_[j].TracksMissing()) {
+            metaData_.SetFeatureCanBeMissed(j, true);
         }
     }
 }
 
+sh_ptr<const DataSet> DataSet::CreateSnapshot(const IDataSet& dataSet, bool sortObjects /*= true*/) {
+    DataSet* snapshot = new DataSet(dataSet);
+    sh_ptr<const DataSet> result(snapshot);
+    if (sortObjects) {
+        for (int j = 0; j < snapshot->GetFeatureCount(); ++j) {
+            snapshot->GetSortedObjectIndexes(j);
+        }
+        snapshot->isSortedIndexesComplete_ = true;
+    }
+    return result;
+}
+
 bool DataSet::HasFeature(int objectIndex, int featureIndex) const {
-    return !IsNaN(GetFeature(objectIndex, featureIndex));
+    CheckObjectIndex(objectIndex);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        return features_[featureIndex].IsPresent(objectIndex);
+    } else {
+        return !metaData_.GetFeatureInfo(featureIndex).CanBeMissed;
+    }
 }
 
 double DataSet::GetFeature(int objectIndex, int featureIndex) const {
-    bool canBeMissed = metaData_.GetFeatureInfo(featureIndex).CanBeMissed; // also checks range for featureIndex
-    if (featureIndex < static_cast<int>(features_.at(objectIndex).size())) {
-        return features_.at(objectIndex).at(featureIndex);
+    CheckObjectIndex(objectIndex);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        return features_[featureIndex].Get(objectIndex);
+    } else {
+        // the column is not created yet, also checks range for featureIndex
+        return metaData_.GetFeatureInfo(featureIndex).CanBeMissed ? NaN : 0;
+    }
+}
+
+void DataSet::GetFeatures(int featureIndex, int objectIndex, int count, double* features) const {
+    CheckObjectRange(objectIndex, count);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        features_[featureIndex].GetValues(objectIndex, count, features);
+    } else if (count > 0) {
+        std::fill(features, features + count, GetFeature(objectIndex, featureIndex));
+    }
+}
+
+void DataSet::GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const {
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        for (int i = 0; i < count; ++i) {
+            CheckObjectIndex(objectIndexes[i]);
+        }
+        features_[featureIndex].GatherValues(objectIndexes, count, features);
     } else {
-        return canBeMissed ? NaN : 0;
+        IDataSet::GatherFeatures(featureIndex, objectIndexes, count, features);
+    }
+}
+
+void DataSet::GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const {
+    CheckObjectRange(objectIndex, count);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        features_[featureIndex].GetValues(objectIndex, count, features);
+    } else if (count > 0) {
+        std::fill(features, features + count, static_cast<float>(GetFeature(objectIndex, featureIndex)));
+    }
+}
+
+void DataSet::GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const {
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        for (int i = 0; i < count; ++i) {
+            CheckObjectIndex(objectIndexes[i]);
+        }
+        features_[featureIndex].GatherValues(objectIndexes, count, features);
+    } else {
+        IDataSet::GatherFloatFeatures(featureIndex, objectIndexes, count, features);
+    }
+}
+
+void DataSet::GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const {
+    CheckObjectRange(objectIndex, count);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        features_[featureIndex].GetCodes(objectIndex, count, codes);
+    } else {
+        IDataSet::GetFeatureCodes(featureIndex, objectIndex, count, codes);
+    }
+}
+
+void DataSet::GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const {
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        for (int i = 0; i < count; ++i) {
+            CheckObjectIndex(objectIndexes[i]);
+        }
+        features_[featureIndex].GatherCodes(objectIndexes, count, codes);
+    } else {
+        IDataSet::GatherFeatureCodes(featureIndex, objectIndexes, count, codes);
+    }
+}
+
+int DataSet::CountPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    CheckObjectRange(objectIndex, count);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        return features_[featureIndex].CountPresent(objectIndex, count);
+    } else {
+        return metaData_.GetFeatureInfo(featureIndex).CanBeMissed ? 0 : count;
+    }
+}
+
+double DataSet::SumPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    CheckObjectRange(objectIndex, count);
+    if (featureIndex >= 0 && featureIndex < static_cast<int>(features_.size())) {
+        return features_[featureIndex].SumPresent(objectIndex, count);
+    } else {
+        metaData_.GetFeatureInfo(featureIndex);
+        return 0;
+    }
+}
+
+sh_ptr< const vector<int> > DataSet::GetSortedObjectIndexes(int featureIndex) const {
+    if (featureIndex < 0 || featureIndex >= static_cast<int>(features_.size())) {
+        return IDataSet::GetSortedObjectIndexes(featureIndex);
+    }
+    if (isSortedIndexesComplete_) {
+        // the cache of a snapshot is not changed any more
+        return sortedIndexes_[featureIndex];
+    }
+    std::lock_guard<std::mutex> lock(sortedIndexesMutex_);
+    if (sortedIndexes_.size() != features_.size()) {
+        sortedIndexes_.resize(features_.size());
+    }
+    if (sortedIndexes_[featureIndex].get() == NULL) {
+        sortedIndexes_[featureIndex] = IDataSet::GetSortedObjectIndexes(featureIndex);
+    }
+    return sortedIndexes_[featureIndex];
+}
+
+void DataSet::GetTargets(int objectIndex, int count, int* targets) const {
+    CheckObjectRange(objectIndex, count);
+    std::copy(targets_.GetData() + objectIndex, targets_.GetData() + objectIndex + count, targets);
+}
+
+void DataSet::GatherTargets(const int* objectIndexes, int count, int* targets) const {
+    for (int i = 0; i < count; ++i) {
+        CheckObjectIndex(objectIndexes[i]);
+        targets[i] = targets_.Get(objectIndexes[i]);
+    }
+}
+
+void DataSet::GetWeights(int objectIndex, int count, double* weights) const {
+    CheckObjectRange(objectIndex, count);
+    std::copy(weights_.GetData() + objectIndex, weights_.GetData() + objectIndex + count, weights);
+}
+
+void DataSet::GatherWeights(const int* objectIndexes, int count, double* weights) const {
+    for (int i = 0; i < count; ++i) {
+        CheckObjectIndex(objectIndexes[i]);
+        weights[i] = weights_.Get(objectIndexes[i]);
+    }
+}
+
+void DataSet::SwapObjects(int objectIndex1, int objectIndex2) {
+    CheckObjectIndex(objectIndex1);
+    CheckObjectIndex(objectIndex2);
+    if (objectIndex1 != objectIndex2) {
+        ClearSortedIndexes();
+    }
+    targets_.Swap(objectIndex1, objectIndex2);
+    weights_.Swap(objectIndex1, objectIndex2);
+    for (vector<FeatureColumn>::iterator it = features_.begin(); it != features_.end(); ++it) {
+        it->Swap(objectIndex1, objectIndex2);
+    }
+    if (!confidences_.empty()) {
+        confidences_.resize(GetObjectCount());
+        confidences_[objectIndex1].swap(confidences_[objectIndex2]);
+    }
+}
+
+void DataSet::ApplyPermutation(const Permutation& permutation) {
+    if (permutation.GetSize() != GetObjectCount()) {
+        throw std::invalid_argument("Permutation size doesn't match the number of objects");
+    }
+    if (GetObjectCount() == 0) {
+        return;
+    }
+    const int* indexes = &permutation.GetIndexes()[0];
+    targets_.Permute(indexes);
+    weights_.Permute(indexes);
+    for (vector<FeatureColumn>::iterator it = features_.begin(); it != features_.end(); ++it) {
+        it->Permute(indexes);
+    }
+    if (!confidences_.empty()) {
+        confidences_.resize(GetObjectCount());
+        vector< vector<double> > confidences(GetObjectCount());
+        for (int i = 0; i < GetObjectCount(); ++i) {
+            confidences[i].swap(confidences_[indexes[i]]);
+        }
+        confidences_.swap(confidences);
+    }
+    // cached orders stay valid up to renumbering of the objects
+    Permutation inverse = permutation.Inverse();
+    const vector<int>& inverseIndexes = inverse.GetIndexes();
+    for (int j = 0; j < static_cast<int>(sortedIndexes_.size()); ++j) {
+        if (sortedIndexes_[j].get() != NULL) {
+            const vector<int>& sortedIndexes = *sortedIndexes_[j];
+            vector<int>* remapped = new vector<int>(sortedIndexes.size());
+            sh_ptr< const vector<int> > result(remapped);
+            for (int i = 0; i < static_cast<int>(sortedIndexes.size()); ++i) {
+                (*remapped)[i] = inverseIndexes[sortedIndexes[i]];
+            }
+            sortedIndexes_[j] = result;
+        }
     }
 }
 
 void DataSet::Resize(int objectCount, int featureCount) {
+    ClearSortedIndexes();
     metaData_.SetFeatureCount(featureCount);
-    targets_.resize(objectCount);
-    weights_.resize(objectCount);
-    features_.resize(objectCount);
+    targets_.Resize(objectCount);
+    weights_.Resize(objectCount);
+    if (featureCount < static_cast<int>(features_.size())) {
+        features_.resize(featureCount);
+    }
     objectCount_ = objectCount;
-    for (int i = 0; i < objectCount; ++i) {
-        features_[i].resize(featureCount);
+    for (int j = 0; j < static_cast<int>(features_.size()); ++j) {
+        features_[j].Resize(objectCount);
+    }
+    CreateColumns();
+}
+
+void DataSet::SetSinglePrecision(bool singlePrecision) {
+    singlePrecision_ = singlePrecision;
+    ClearSortedIndexes();
+    for (int j = 0; j < static_cast<int>(features_.size()); ++j) {
+        ColumnType type = features_[j].GetType();
+        if (type == DoubleColumn || type == FloatColumn) {
+            features_[j].ConvertTo(singlePrecision ? FloatColumn : DoubleColumn);
+        }
     }
 }
 
 void DataSet::SetFeature(int objectIndex, int featureIndex, double feature) {
-    features_.at(objectIndex).resize(metaData_.GetFeatureCount());
-    features_.at(objectIndex).at(featureIndex) = feature;
+    CheckObjectIndex(objectIndex);
+    if (featureIndex >= static_cast<int>(features_.size())) {
+        CreateColumns();
+    }
+    features_.at(featureIndex).Set(objectIndex, feature);
+    if (featureIndex < static_cast<int>(sortedIndexes_.size())) {
+        sortedIndexes_[featureIndex] = sh_ptr< const vector<int> >();
+    }
+    isSortedIndexesComplete_ = false;
+    if (IsNaN(feature) && !metaData_.GetFeatureInfo(featureIndex).CanBeMissed) {
+        metaData_.SetFeatureCanBeMissed(featureIndex, true);
+    }
+}
+
+void DataSet::CheckObjectIndex(int objectIndex) const {
+    if (objectIndex < 0 || objectIndex >= objectCount_) {
+        throw std::out_of_range("Object index was out of range");
+    }
+}
+
+void DataSet::CheckObjectRange(int objectIndex, int count) const {
+    if (count < 0 || objectIndex < 0 || objectIndex > objectCount_ - count) {
+        throw std::out_of_range("Object index was out of range");
+    }
+}
+
+void DataSet::CreateColumns() {
+    int oldFeatureCount = features_.size();
+    features_.resize(GetFeatureCount());
+    for (int j = oldFeatureCount; j < GetFeatureCount(); ++j) {
+        FeatureInfo info = metaData_.GetFeatureInfo(j);
+        features_[j] = FeatureColumn(objectCount_, 0,
+            FeatureColumn::GetCompactType(info.Type, info.NominalValues.size(), singlePrecision_));
+        if (info.CanBeMissed) {
+            features_[j].TrackMissing();
+        }
+    }
+}
+
+void DataSet::CompactColumns() {
+    CreateColumns();
+    for (int j = 0; j < GetFeatureCount(); ++j) {
+        FeatureInfo info = metaData_.GetFeatureInfo(j);
+        features_[j].ConvertTo(FeatureColumn::GetCompactType(info.Type, info.NominalValues.size(), singlePrecision_));
+    }
 }
 
 void DataSet::Clear() {
     objectCount_ = 0;
-    targets_.clear();
-    weights_.clear();
+    ClearSortedIndexes();
+    targets_.Clear();
+    weights_.Clear();
     features_.clear();
+    mappedFile_ = sh_ptr<MappedFile>();
 }
 
-bool DataSet::Load(const string& fileName, DataFileFormat format /*= UnknownFormat*/) {
+bool DataSet::Load(const string& fileName, DataFileFormat format /*= UnknownFormat*/, int threadCount /*= 1*/) {
     if (format == UnknownFormat) {
         if (fileName.length() >= 5 && fileName.substr(fileName.length() - 5) == ".arff") {
             format = Arff;
+        } else if (fileName.length() >= 5 && fileName.substr(fileName.length() - 5) == ".mllb") {
+            format = Mllb;
         } else {
             format = SvmLight;
         }
     }
+    if (format == Mllb) {
+        return LoadBinary(fileName);
+    }
+    if (format == Arff) {
+        MappedFile file;
+        if (file.Open(fileName)) {
+            Clear();
+            return LoadArff(file.GetData(), file.GetData() + file.GetSize(), threadCount);
+        }
+    }
     std::ifstream input(fileName.c_str());
     if (!input.is_open()) {
         return false;
     }
     Clear();
     if (format == Arff) {
-        return LoadArff(input);
+        return LoadArff(input, threadCount);
     } else {
         return LoadSvmLight(input);
     }
 }
 
-bool DataSet::LoadArff(std::istream& input) {
-    bool dataAchieved = false;
-    bool relationAchieved = false;
-    int targetIndex = -1;
-    while (!input.eof()) {
-        string line;
-        getline(input, line);
-        Tokenizer tokenizer(line);
-        tokenizer.GetQuotes().push_back('"');
-        tokenizer.GetDelimeters().push_back(',');
-        if (line[tokenizer.GetPosition()] == '%') {
-            continue;
+bool DataSet::SaveBinary(const string& fileName) const {
+    int featureCount = GetFeatureCount();
+    int classCount = GetClassCount();
+    BinaryWriter header;
+    for (int i = 0; i < 4; ++i) {
+        header.Write(BinaryMagic[i]);
+    }
+    header.Write<uint32_t>(BinaryVersion);
+    header.Write<uint32_t>(ByteOrderMark);
+    header.Write<uint32_t>(objectCount_);
+    header.Write<uint32_t>(featureCount);
+    header.WriteString(metaData_.GetName());
+    for (int j = 0; j < featureCount; ++j) {
+        FeatureInfo info = metaData_.GetFeatureInfo(j);
+        header.WriteString(info.Name);
+        header.Write<uint32_t>(info.Type);
+        header.Write<uint32_t>(info.CanBeMissed);
+        header.Write<uint32_t>(j < static_cast<int>(features_.size()) ? features_[j].GetType() : DoubleColumn);
+        header.WriteStrings(info.NominalValues);
+    }
+    FeatureInfo targetInfo = metaData_.GetTargetInfo();
+    header.WriteString(targetInfo.Name);
+    header.Write<uint32_t>(targetInfo.CanBeMissed);
+    header.WriteStrings(targetInfo.NominalValues);
+    for (int i = 0; i < classCount; ++i) {
+        for (int j = 0; j < classCount; ++j) {
+            header.Write<double>(metaData_.GetPenalty(i, j));
+        }
+        header.Write<double>(metaData_.GetPenalty(i, Refuse));
+    }
+
+    // section table
+    vector<uint64_t> offsets;
+    uint64_t offset = AlignOffset(header.GetData().length() + (2 + 2 * featureCount) * sizeof(uint64_t));
+    offsets.push_back(offset);
+    offset = AlignOffset(offset + objectCount_ * sizeof(int));
+    offsets.push_back(offset);
+    offset = AlignOffset(offset + objectCount_ * sizeof(double));
+    for (int j = 0; j < featureCount; ++j) {
+        offsets.push_back(offset);
+        if (j < static_cast<int>(features_.size())) {
+            offset = AlignOffset(offset + features_[j].GetRawSize());
+        } else {
+            offset = AlignOffset(offset + objectCount_ * sizeof(double));
+        }
+    }
+    for (int j = 0; j < featureCount; ++j) {
+        if (metaData_.GetFeatureInfo(j).CanBeMissed) {
+            offsets.push_back(offset);
+            offset = AlignOffset(offset + GetBitmapSize(objectCount_));
+        } else {
+            offsets.push_back(0);
         }
-        if (!tokenizer.ReadNext()) {
+    }
+    for (vector<uint64_t>::const_iterator it = offsets.begin(); it != offsets.end(); ++it) {
+        header.Write<uint64_t>(*it);
+    }
+
+    std::ofstream output(fileName.c_str(), std::ios::out | std::ios::binary);
+    if (!output.is_open()) {
+        return false;
+    }
+    const string& headerData = header.GetData();
+    output.write(headerData.data(), headerData.length());
+    string padding(DefaultAlignment, '\0');
+    size_t position = headerData.length();
+    vector<double> features(objectCount_);
+    vector<uint64_t> bitmap(GetBitmapSize(objectCount_) / sizeof(uint64_t));
+    for (int section = 0; section < static_cast<int>(offsets.size()); ++section) {
+        if (offsets[section] == 0) {
             continue;
         }
-        if (!relationAchieved) {
-            string tag = tokenizer.GetCurrentToken();
-            ToLower(&tag);
-            if (tag != "@relation") {
-                return false;
-            }
-            if (!tokenizer.ReadNext()) {
-                return false;
-            }
-            metaData_.SetName(tokenizer.GetCurrentToken());
-            relationAchieved = true;
-        } else if (!dataAchieved) {
-            string tag = tokenizer.GetCurrentToken();
-            ToLower(&tag);
-            if (tag == "@data") {
-                dataAchieved = true;
-            } else if (tag == "@attribute") {
-                if (!tokenizer.ReadNext()) {
-                    return false;
-                }
-                string attributeName = tokenizer.GetCurrentToken();
-                vector<string> nominalValues;
-                FeatureType attributeType = UnknownType;
-                if (line[tokenizer.GetPosition()] != '{') {
-                    if (!tokenizer.ReadNext()) {
-                        return false;
-                    }
-                    string type = tokenizer.GetCurrentToken();
-                    ToLower(&type);
-                    if (type == "numeric" || type == "real") {
-                        attributeType = Numeric;
-                    } else if (type == "string" || type == "date") {
-                        attributeType = UnknownType;
-                    } else {
-                        return false;
-                    }
-                } else {
-                    tokenizer.GetDelimeters().push_back('{');
-                    tokenizer.GetDelimeters().push_back('}');
-                    tokenizer.ReadNext();
-                    attributeType = Nominal;
-                    while (tokenizer.ReadNext()) {
-                        nominalValues.push_back(tokenizer.GetCurrentToken());
-                    }
-                }
-                if (attributeType == Nominal && attributeName == "class") {
-                    metaData_.SetTargetInfo(FeatureInfo(attributeName, attributeType, false, nominalValues));
-                    targetIndex = GetFeatureCount();
-                } else {
-                    metaData_.AddFeature(FeatureInfo(attributeName, attributeType, false, nominalValues));
-                }
-            } else {
-                return false;
+        output.write(padding.data(), offsets[section] - position);
+        const char* data = NULL;
+        size_t size = 0;
+        if (section == 0) {
+            data = reinterpret_cast<const char*>(targets_.GetData());
+            size = objectCount_ * sizeof(int);
+        } else if (section == 1) {
+            data = reinterpret_cast<const char*>(weights_.GetData());
+            size = objectCount_ * sizeof(double);
+        } else if (section < 2 + static_cast<int>(features_.size())) {
+            data = static_cast<const char*>(features_[section - 2].GetRawData());
+            size = features_[section - 2].GetRawSize();
+        } else if (section < 2 + featureCount) {
+            if (objectCount_ > 0) {
+                GetFeatures(section - 2, 0, objectCount_, &features[0]);
             }
+            data = reinterpret_cast<const char*>(features.empty() ? NULL : &features[0]);
+            size = objectCount_ * sizeof(double);
         } else {
-            if (targetIndex == -1) {
-                return false;
-            }
-            int objectIndex = AddObject();
-            tokenizer.SetPosition(0);
-            int attributeIndex;
-            for (attributeIndex = 0; tokenizer.ReadNext(); ++attributeIndex) {
-                if (attributeIndex > GetFeatureCount() + 1) {
-                    return false;
-                }
-                bool isTarget = attributeIndex == targetIndex;
-                int featureIndex = attributeIndex > targetIndex ? attributeIndex - 1 : attributeIndex;
-                FeatureInfo info = isTarget ? metaData_.GetTargetInfo() : metaData_.GetFeatureInfo(featureIndex);
-                const string& current = tokenizer.GetCurrentToken();
-                if (current == "?") {
-                    if (isTarget) {
-                        return false;
-                    } else {
-                        metaData_.SetFeatureCanBeMissed(attributeIndex, true);
-                        SetFeature(objectIndex, featureIndex, NaN);
-                    }
-                } else {
-                    switch (info.Type) {
-                        case Numeric: {
-                            SetFeature(objectIndex, featureIndex, tokenizer.GetCurrent<double>());
-                            break;
-                        }
-                        case Nominal: {
-                            int classValue = find(info.NominalValues.begin(), info.NominalValues.end(), tokenizer.GetCurrentToken()) - info.NominalValues.begin();
-                            if (classValue >= static_cast<int>(info.NominalValues.size())) {
-                                return false;
-                            }
-                            if (isTarget) {
-                                SetTarget(objectIndex, classValue);
-                            } else {
-                                SetFeature(objectIndex, featureIndex, classValue);
-                            }
-                            break;
-                        }
-                        default: {
-                            SetFeature(objectIndex, featureIndex, 0);
-                            break;
-                        }
+            int featureIndex = section - 2 - featureCount;
+            if (featureIndex < static_cast<int>(features_.size()) && features_[featureIndex].TracksMissing()) {
+                data = reinterpret_cast<const char*>(features_[featureIndex].GetPresent().GetWords());
+            } else {
+                std::fill(bitmap.begin(), bitmap.end(), 0);
+                for (int i = 0; i < objectCount_; ++i) {
+                    if (HasFeature(i, featureIndex)) {
+                        bitmap[i / 64] |= static_cast<uint64_t>(1) << (i % 64);
                     }
                 }
+                data = reinterpret_cast<const char*>(bitmap.empty() ? NULL : &bitmap[0]);
             }
-            if (attributeIndex != GetFeatureCount() + 1) {
+            size = bitmap.size() * sizeof(uint64_t);
+        }
+        if (size > 0) {
+            output.write(data, size);
+        }
+        position = offsets[section] + size;
+    }
+    return output.good();
+}
+
+bool DataSet::LoadBinary(const string& fileName) {
+    sh_ptr<MappedFile> file(new MappedFile());
+    if (!file->Open(fileName)) {
+        return false;
+    }
+    BinaryReader reader(file->GetData(), file->GetSize());
+    char magic[4];
+    uint32_t version, byteOrderMark, objectCount, featureCount;
+    for (int i = 0; i < 4; ++i) {
+        if (!reader.Read(&magic[i]) || magic[i] != BinaryMagic[i]) {
+            return false;
+        }
+    }
+    if (!reader.Read(&version) || version < 1 || version > BinaryVersion ||
+        !reader.Read(&byteOrderMark) || byteOrderMark != ByteOrderMark ||
+        !reader.Read(&objectCount) || objectCount > static_cast<uint32_t>(std::numeric_limits<int>::max()) ||
+        !reader.Read(&featureCount) || sizeof(int) != sizeof(uint32_t))
+    {
+        return false;
+    }
+
+    MetaData metaData;
+    string name;
+    if (!reader.ReadString(&name)) {
+        return false;
+    }
+    metaData.SetName(name);
+    vector<ColumnType> columnTypes(featureCount, DoubleColumn);
+    for (uint32_t j = 0; j < featureCount; ++j) {
+        string featureName;
+        uint32_t type, canBeMissed, columnType = DoubleColumn;
+        vector<string> nominalValues;
+        if (!reader.ReadString(&featureName) ||
+            !reader.Read(&type) || type > Nominal ||
+            !reader.Read(&canBeMissed) ||
+            (version >= 2 && (!reader.Read(&columnType) || columnType > FloatColumn)) ||
+            !reader.ReadStrings(&nominalValues))
+        {
+            return false;
+        }
+        columnTypes[j] = static_cast<ColumnType>(columnType);
+        metaData.AddFeature(FeatureInfo(featureName, static_cast<FeatureType>(type), canBeMissed != 0, nominalValues));
+    }
+    string targetName;
+    uint32_t allowRefuse;
+    vector<string> classNames;
+    if (!reader.ReadString(&targetName) ||
+        !reader.Read(&allowRefuse) ||
+        !reader.ReadStrings(&classNames))
+    {
+        return false;
+    }
+    metaData.SetTargetInfo(FeatureInfo(targetName, Nominal, allowRefuse != 0, classNames));
+    for (int i = 0; i < metaData.GetClassCount(); ++i) {
+        for (int j = 0; j <= metaData.GetClassCount(); ++j) {
+            double penalty;
+            if (!reader.Read(&penalty)) {
                 return false;
             }
+            metaData.SetPenalty(i, j < metaData.GetClassCount() ? j : Refuse, penalty);
+        }
+    }
+
+    vector<uint64_t> offsets(2 + 2 * featureCount);
+    for (int section = 0; section < static_cast<int>(offsets.size()); ++section) {
+        if (!reader.Read(&offsets[section])) {
+            return false;
+        }
+    }
+    if (!reader.CheckSection(offsets[0], objectCount * sizeof(int)) ||
+        !reader.CheckSection(offsets[1], objectCount * sizeof(double)))
+    {
+        return false;
+    }
+    for (uint32_t j = 0; j < featureCount; ++j) {
+        if (!reader.CheckSection(offsets[2 + j], GetColumnSize(columnTypes[j], objectCount)) ||
+            (offsets[2 + featureCount + j] != 0 &&
+             !reader.CheckSection(offsets[2 + featureCount + j], GetBitmapSize(objectCount))))
+        {
+            return false;
+        }
+    }
+
+    Clear();
+    metaData_ = metaData;
+    objectCount_ = objectCount;
+    const char* data = file->GetData();
+    targets_.SetExternal(reinterpret_cast<const int*>(data + offsets[0]), objectCount);
+    weights_.SetExternal(reinterpret_cast<const double*>(data + offsets[1]), objectCount);
+    features_.resize(featureCount);
+    for (uint32_t j = 0; j < featureCount; ++j) {
+        features_[j].SetExternal(columnTypes[j], data + offsets[2 + j], objectCount);
+        if (offsets[2 + featureCount + j] != 0) {
+            features_[j].SetExternalPresent(reinterpret_cast<const uint64_t*>(data + offsets[2 + featureCount + j]));
         }
     }
+    mappedFile_ = file;
+    if (singlePrecision_) {
+        SetSinglePrecision(true);
+    }
+    return true;
+}
+
+bool DataSet::LoadArff(std::istream& input, int threadCount) {
+    std::ostringstream buffer;
+    buffer << input.rdbuf();
+    string data = buffer.str();
+    return LoadArff(data.data(), data.data() + data.length(), threadCount);
+}
+
+bool DataSet::LoadArff(const char* begin, const char* end, int threadCount) {
+    ArffParser parser(singlePrecision_);
+    const char* dataBegin;
+    if (!parser.ParseHeader(begin, end, &metaData_, &dataBegin)) {
+        return false;
+    }
+    ArffData data;
+    if (threadCount == 1) {
+        if (!parser.ParseData(dataBegin, end, &data)) {
+            return false;
+        }
+    } else if (threadCount == 0) {
+        if (!parser.ParseData(dataBegin, end, &data, &ThreadPool::GetGlobal())) {
+            return false;
+        }
+    } else {
+        ThreadPool pool(threadCount);
+        if (!parser.ParseData(dataBegin, end, &data, &pool)) {
+            return false;
+        }
+    }
+    for (int j = 0; j < static_cast<int>(data.Missed.size()); ++j) {
+        if (data.Missed[j]) {
+            metaData_.SetFeatureCanBeMissed(j, true);
+        }
+    }
+    objectCount_ = data.ObjectCount;
+    features_.swap(data.Features);
+    targets_.Swap(data.Targets);
+    weights_.Resize(objectCount_, 1.0);
     return true;
 }
 
 bool DataSet::LoadSvmLight(std::istream& input) {
-    return false; // not implemented yet
+    SparseDataSet sparseDataSet;
+    if (!sparseDataSet.LoadSvmLight(input)) {
+        return false;
+    }
+    // the number of features is the greatest index in the file, one index can make the matrix huge
+    int64_t valueCount = 0;
+    for (int i = 0; i < sparseDataSet.GetObjectCount(); ++i) {
+        valueCount += sparseDataSet.GetNonZeroCount(i);
+    }
+    int64_t cellCount = static_cast<int64_t>(sparseDataSet.GetObjectCount()) * sparseDataSet.GetFeatureCount();
+    if (cellCount > std::max(MinDenseCellLimit, MaxDenseCellsPerValue * valueCount)) {
+        LOGE("SVM-Light data of %d objects and %d features with %lld stored values is too sparse "
+             "for a dense dataset, load it with SparseDataSet",
+             sparseDataSet.GetObjectCount(), sparseDataSet.GetFeatureCount(),
+             static_cast<long long>(valueCount));
+        return false;
+    }
+    bool singlePrecision = singlePrecision_;
+    *this = DataSet(sparseDataSet);
+    SetSinglePrecision(singlePrecision);
+    return true;
 }
 
 int DataSet::AddObject() {
-    features_.push_back(vector<double>(GetFeatureCount()));
-    targets_.push_back(0);
-    weights_.push_back(1);
+    ClearSortedIndexes();
+    CreateColumns();
+    for (vector<FeatureColumn>::iterator it = features_.begin(); it != features_.end(); ++it) {
+        it->PushBack(0);
+    }
+    targets_.PushBack(0);
+    weights_.PushBack(1);
     return objectCount_++;
 }
 
@@ -1,29 +1,59 @@
 #ifndef DATASET_H_
 #define DATASET_H_
 
+#include "aligned_array.h"
+#include "column.h"
 #include "data.h"
+#include "mapped_file.h"
 #include "metadata.h"
+#include "thread_pool.h"
 
 namespace mll {
 
+//! If numeric features are stored as floats by default
+#ifdef MLL_FLOAT_FEATURES
+const bool DefaultSinglePrecision = true;
+#else
+const bool DefaultSinglePrecision = false;
+#endif
+
 //! Format of file with data
 enum DataFileFormat {
     UnknownFormat,
     Arff,
-    SvmLight
+    SvmLight,
+    Mllb
 };
 
 //! Simple dataset. Implements IDataSet interface.
+/*! Features are stored column-major: one contiguous aligned buffer per feature.
+    Features which can be missed also keep bitmaps of present values.
+    Binary and nominal features are stored as bits or small integer codes,
+    other ones can be stored as floats (see SetSinglePrecision).
+    Data loaded from a binary (.mllb) file is memory-mapped, its arrays are
+    copied only when they are modified.
+    Const methods can be called concurrently while nobody changes the data,
+    orders of objects by features are built on the first request under a lock.
+    Snapshots (see CreateSnapshot) are read with no locking at all.
+*/
 class DataSet : public IDataSet {	
 public:
     //! Default initialization
 	DataSet()
-        : objectCount_(0) {
+        : objectCount_(0),
+          isSortedIndexesComplete_(false),
+          singlePrecision_(DefaultSinglePrecision) {
     }
 
     //! Copy-constructor
     DataSet(const IDataSet& dataSet);
 
+    //! Creates an immutable copy of the data which any number of threads can read with no locking
+    /*! Orders of objects by all features are built on creation, unless
+        sortObjects is false (then they are built on request under a lock).
+    */
+    static sh_ptr<const DataSet> CreateSnapshot(const IDataSet& dataSet, bool sortObjects = true);
+
     //! Gets metadata about the dataset
     virtual const IMetaData& GetMetaData() const {
         return metaData_;
@@ -50,25 +80,29 @@ public:
 
     //! Gets the object's value of the target feature
     virtual int GetTarget(int objectIndex) const {
-        return targets_.at(objectIndex);
+        CheckObjectIndex(objectIndex);
+        return targets_.Get(objectIndex);
     }
 
     //! Sets the object's value of the target feature
     virtual void SetTarget(int objectIndex, int target) {
         if (target >= 0 && target < GetClassCount()) {
-            targets_.at(objectIndex) = target;
+            CheckObjectIndex(objectIndex);
+            targets_.Set(objectIndex, target);
         }
     }
 
     //! Gets the object's weight
     virtual double GetWeight(int objectIndex) const {
-        return weights_.at(objectIndex);
+        CheckObjectIndex(objectIndex);
+        return weights_.Get(objectIndex);
     }
 
     //! Sets the object's weight
     virtual void SetWeight(int objectIndex, double weight) {
         if (weight >= 0) {
-            weights_.at(objectIndex) = weight;
+            CheckObjectIndex(objectIndex);
+            weights_.Set(objectIndex, weight);
         }
     }
 
@@ -83,11 +117,59 @@ public:
     //! Sets the object classification confidence for the target
     virtual void SetConfidence(int objectIndex, int target, double confidence);
 
+    //! Gets the feature values of count objects starting from objectIndex
+    virtual void GetFeatures(int featureIndex, int objectIndex, int count, double* features) const;
+    //! Gets the feature values of the listed objects
+    virtual void GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const;
+    //! Gets the targets of count objects starting from objectIndex
+    virtual void GetTargets(int objectIndex, int count, int* targets) const;
+    //! Gets the targets of the listed objects
+    virtual void GatherTargets(const int* objectIndexes, int count, int* targets) const;
+    //! Gets the weights of count objects starting from objectIndex
+    virtual void GetWeights(int objectIndex, int count, double* weights) const;
+    //! Gets the weights of the listed objects
+    virtual void GatherWeights(const int* objectIndexes, int count, double* weights) const;
+    //! Gets the feature values of count objects starting from objectIndex as floats
+    virtual void GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const;
+    //! Gets the feature values of the listed objects as floats
+    virtual void GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const;
+    //! Gets the feature values of count objects starting from objectIndex as integer codes
+    virtual void GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const;
+    //! Gets the feature values of the listed objects as integer codes
+    virtual void GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const;
+    //! Counts objects which have the feature value (by bitmap of present values)
+    virtual int CountPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Sums present feature values (skipping missed values by bitmap)
+    virtual double SumPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Gets indices of all objects ordered by the feature value (built once per feature and cached)
+    virtual sh_ptr< const std::vector<int> > GetSortedObjectIndexes(int featureIndex) const;
+
+    //! Gets all values of the feature (direct access to the storage)
+    const FeatureColumn& GetColumn(int featureIndex) const {
+        return features_.at(featureIndex);
+    }
+
     //! Swaps two objects
-    virtual void SwapObjects(int objectIndex1, int objectIndex2) {
-        std::swap(features_.at(objectIndex1), features_.at(objectIndex2));
-        std::swap(targets_.at(objectIndex1), targets_.at(objectIndex2));
-        std::swap(weights_.at(objectIndex1), weights_.at(objectIndex2));
+    virtual void SwapObjects(int objectIndex1, int objectIndex2);
+    //! Reorders all columns at once (cached orders by features are renumbered, not rebuilt)
+    virtual void ApplyPermutation(const Permutation& permutation);
+
+    //! Stores binary and nominal features in compact columns (bits, uint8 or uint16 codes)
+    /*! Features which values don't fit the compact types are kept as doubles.
+        Columns are compacted on loading and on creation, this is needed only
+        when feature types were changed after the values were set.
+    */
+    void CompactColumns();
+
+    //! Stores non-nominal features as floats (or doubles), converts existing columns.
+    /*! The setting is kept on loading, so it can be set before Load to parse
+        data directly to floats. Default is set by MLL_FLOAT_FEATURES build option.
+    */
+    void SetSinglePrecision(bool singlePrecision);
+
+    //! Returns true if numeric features are stored as floats
+    bool IsSinglePrecision() const {
+        return singlePrecision_;
     }
 
 	//! Clears all data from dataset
@@ -100,20 +182,49 @@ public:
     int AddObject();
 
 	//! Loads data from file
-    bool Load(const std::string& fileName, DataFileFormat format = UnknownFormat);
+    /*! ARFF files are parsed on threadCount threads (0 for the threads of the global pool),
+        the result doesn't depend on the number of threads.
+    */
+    bool Load(const std::string& fileName, DataFileFormat format = UnknownFormat, int threadCount = 1);
+
+    //! Saves data to binary (.mllb) file which can be loaded with no parsing
+    bool SaveBinary(const std::string& fileName) const;
 
 private:
     //! Loads data from ARFF file
-    bool LoadArff(std::istream& input);
-    //! Loads data from SVM-Light file
+    bool LoadArff(std::istream& input, int threadCount);
+    //! Parses ARFF data from memory buffer [begin, end)
+    bool LoadArff(const char* begin, const char* end, int threadCount);
+    //! Loads data from SVM-Light file (use SparseDataSet to keep it sparse)
+    /*! Fails if the dense matrix would be much larger than the stored values
+        (e.g. a single large feature index), such data must stay sparse.
+    */
     bool LoadSvmLight(std::istream& input);
+    //! Maps data from binary (.mllb) file
+    bool LoadBinary(const std::string& fileName);
+    //! Throws if the object index is out of range
+    void CheckObjectIndex(int objectIndex) const;
+    //! Throws if the range of objects is out of range
+    void CheckObjectRange(int objectIndex, int count) const;
+    //! Creates columns for all features declared in metadata
+    void CreateColumns();
+    //! Drops cached orders of objects (after the objects were changed)
+    void ClearSortedIndexes() {
+        sortedIndexes_.clear();
+        isSortedIndexesComplete_ = false;
+    }
 
 	MetaData metaData_;				                    //!< Metadata
     int objectCount_;                                   //!< Number of objects
-    std::vector< std::vector<double> > features_;       //!< Features matrix
-    std::vector<int> targets_;                          //!< Targets vector
-    std::vector<double> weights_;                       //!< Weights vector
+    std::vector<FeatureColumn> features_;               //!< Features columns
+    AlignedArray<int> targets_;                         //!< Targets vector
+    AlignedArray<double> weights_;                      //!< Weights vector
     std::vector< std::vector<double> > confidences_;    //!< Confidences matrix
+    sh_ptr<MappedFile> mappedFile_;                     //!< File mapped by LoadBinary
+    mutable std::vector< sh_ptr< const std::vector<int> > > sortedIndexes_;  //!< Cached orders of objects by features
+    mutable CopyableMutex sortedIndexesMutex_;          //!< Guards the cached orders for concurrent readers
+    bool isSortedIndexesComplete_;                      //!< If orders by all features are cached (read with no lock)
+    bool singlePrecision_;                              //!< If numeric features are stored as floats
 };
 
 } // namespace mll
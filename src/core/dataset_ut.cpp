@@ -0,0 +1,512 @@
+#include <gtest/gtest.h>
+
+#include "dataset.h"
+#include "dataset_wrapper.h"
+
+using namespace mll;
+
+class DataSetTest : public testing::Test { };
+
+namespace {
+
+//! Compares orders and values of the snapshot with the expected ones
+class SnapshotReader {
+public:
+	SnapshotReader(const DataSet* snapshot, const IDataSet* expected,
+				   const std::vector< sh_ptr< const std::vector<int> > >& sorted, std::vector<int>* mismatches)
+		: snapshot_(snapshot), expected_(expected), sorted_(sorted), mismatches_(mismatches) { }
+
+	void operator() (int first, int last) const {
+		for (int t = first; t < last; t++) {
+			for (int j = 0; j < snapshot_->GetFeatureCount(); j++) {
+				if (*snapshot_->GetSortedObjectIndexes(j) != *sorted_[j]) {
+					mismatches_->at(t)++;
+				}
+				for (int i = t; i < snapshot_->GetObjectCount(); i += 7) {
+					if (snapshot_->GetFeature(i, j) != expected_->GetFeature(i, j)) {
+						mismatches_->at(t)++;
+					}
+				}
+			}
+		}
+	}
+
+private:
+	const DataSet* snapshot_;
+	const IDataSet* expected_;
+	const std::vector< sh_ptr< const std::vector<int> > >& sorted_;
+	std::vector<int>* mismatches_;
+};
+
+} // namespace
+
+TEST_F(DataSetTest, ColumnStorageTest)
+{
+	const int OBJECTS = 100;
+	const int FEATURES = 7;
+
+	DataSet dataSet;
+	dataSet.SetSinglePrecision(false);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, 0);
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			dataSet.SetFeature(i, j, i * FEATURES + j);
+		}
+	}
+
+	int objectIndex = dataSet.AddObject();
+	ASSERT_EQ(OBJECTS, objectIndex);
+	ASSERT_EQ(OBJECTS + 1, dataSet.GetObjectCount());
+	ASSERT_EQ(0.0, dataSet.GetFeature(objectIndex, FEATURES - 1));
+
+	dataSet.SwapObjects(0, OBJECTS - 1);
+	for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+		const FeatureColumn& column = dataSet.GetColumn(j);
+		ASSERT_EQ(dataSet.GetObjectCount(), column.GetSize());
+		ASSERT_EQ(0, reinterpret_cast<size_t>(column.GetData()) % DefaultAlignment);
+		ASSERT_EQ((OBJECTS - 1) * FEATURES + j, column.GetData()[0]);
+		for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+			ASSERT_EQ(dataSet.GetFeature(i, j), column.GetData()[i]);
+		}
+	}
+
+	ASSERT_THROW(dataSet.GetFeature(dataSet.GetObjectCount(), 0), std::out_of_range);
+	ASSERT_THROW(dataSet.SetFeature(0, FEATURES, 1.0), std::out_of_range);
+}
+
+TEST_F(DataSetTest, BinaryFormatTest)
+{
+	Random random(1);
+	const char* FILE_NAME = "dataset_ut.mllb";
+
+	const int OBJECTS = 130;
+	const int FEATURES = 4;
+
+	std::vector<std::string> classes;
+	classes.push_back("yes");
+	classes.push_back("no");
+	classes.push_back("maybe");
+
+	DataSet dataSet;
+	dataSet.GetMetaData().SetName("binary");
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.GetMetaData().SetPenalty(0, 2, 0.5);
+	dataSet.Resize(OBJECTS, FEATURES);
+	dataSet.GetMetaData().SetFeatureName(1, "nominal");
+	dataSet.GetMetaData().SetFeatureType(1, Nominal);
+	dataSet.GetMetaData().SetFeatureNominalValues(1, classes);
+	dataSet.GetMetaData().SetFeatureCanBeMissed(3, true);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, i % 3);
+		dataSet.SetWeight(i, 1.0 / (i + 1));
+		dataSet.SetFeature(i, 0, random.NextDouble());
+		dataSet.SetFeature(i, 1, random.NextInt(3));
+		dataSet.SetFeature(i, 2, -i);
+		dataSet.SetFeature(i, 3, i % 5 ? i : NaN);
+	}
+	dataSet.CompactColumns();
+	ASSERT_EQ(UInt8Column, dataSet.GetColumn(1).GetType());
+	ASSERT_TRUE(dataSet.SaveBinary(FILE_NAME));
+
+	DataSet mappedDataSet;
+	ASSERT_TRUE(mappedDataSet.Load(FILE_NAME));
+	ASSERT_EQ(dataSet.GetName(), mappedDataSet.GetName());
+	ASSERT_EQ(dataSet.GetObjectCount(), mappedDataSet.GetObjectCount());
+	ASSERT_EQ(dataSet.GetFeatureCount(), mappedDataSet.GetFeatureCount());
+	ASSERT_EQ(dataSet.GetClassCount(), mappedDataSet.GetClassCount());
+	ASSERT_EQ(0.5, mappedDataSet.GetMetaData().GetPenalty(0, 2));
+	ASSERT_EQ(UInt8Column, mappedDataSet.GetColumn(1).GetType());
+	for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+		FeatureInfo info = dataSet.GetMetaData().GetFeatureInfo(j);
+		FeatureInfo mappedInfo = mappedDataSet.GetMetaData().GetFeatureInfo(j);
+		ASSERT_EQ(info.Name, mappedInfo.Name);
+		ASSERT_EQ(info.Type, mappedInfo.Type);
+		ASSERT_EQ(info.CanBeMissed, mappedInfo.CanBeMissed);
+		ASSERT_TRUE(info.NominalValues == mappedInfo.NominalValues);
+	}
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		ASSERT_EQ(dataSet.GetTarget(i), mappedDataSet.GetTarget(i));
+		ASSERT_EQ(dataSet.GetWeight(i), mappedDataSet.GetWeight(i));
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			ASSERT_EQ(dataSet.HasFeature(i, j), mappedDataSet.HasFeature(i, j));
+			if (dataSet.HasFeature(i, j)) {
+				ASSERT_EQ(dataSet.GetFeature(i, j), mappedDataSet.GetFeature(i, j));
+			}
+		}
+	}
+
+	ASSERT_EQ(dataSet.CountPresentFeatures(3, 0, OBJECTS), mappedDataSet.CountPresentFeatures(3, 0, OBJECTS));
+	ASSERT_EQ(dataSet.SumPresentFeatures(3, 1, OBJECTS - 1), mappedDataSet.SumPresentFeatures(3, 1, OBJECTS - 1));
+
+	// mapped data is copied on write
+	mappedDataSet.SetFeature(0, 0, -1.0);
+	mappedDataSet.SwapObjects(0, 1);
+	ASSERT_EQ(-1.0, mappedDataSet.GetFeature(1, 0));
+	ASSERT_EQ(dataSet.GetTarget(0), mappedDataSet.GetTarget(1));
+
+	remove(FILE_NAME);
+}
+
+TEST_F(DataSetTest, SinglePrecisionBinaryTest)
+{
+	const char* FILE_NAME = "dataset_ut_float.mllb";
+
+	const int OBJECTS = 70;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 2);
+	dataSet.SetSinglePrecision(true);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, 1.0);
+		dataSet.SetFeature(i, 0, i + 0.25);
+		dataSet.SetFeature(i, 1, i % 7 ? -0.5 * i : NaN);
+	}
+	ASSERT_EQ(FloatColumn, dataSet.GetColumn(0).GetType());
+	ASSERT_TRUE(dataSet.SaveBinary(FILE_NAME));
+
+	// float columns are stored with 4 bytes per value
+	DataSet mappedDataSet;
+	ASSERT_TRUE(mappedDataSet.Load(FILE_NAME));
+	ASSERT_EQ(OBJECTS, mappedDataSet.GetObjectCount());
+	for (int j = 0; j < 2; j++) {
+		ASSERT_EQ(FloatColumn, mappedDataSet.GetColumn(j).GetType());
+	}
+	for (int i = 0; i < OBJECTS; i++) {
+		for (int j = 0; j < 2; j++) {
+			ASSERT_EQ(dataSet.HasFeature(i, j), mappedDataSet.HasFeature(i, j));
+			if (dataSet.HasFeature(i, j)) {
+				ASSERT_EQ(dataSet.GetFeature(i, j), mappedDataSet.GetFeature(i, j));
+			}
+		}
+	}
+
+	remove(FILE_NAME);
+}
+
+TEST_F(DataSetTest, MissingValuesTest)
+{
+	const int OBJECTS = 200;
+
+	DataSet dataSet;
+	dataSet.Resize(OBJECTS, 2);
+	double sum = 0;
+	int presentCount = 0;
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, i);
+		dataSet.SetFeature(i, 1, i % 3 ? i : NaN);
+		if (i >= 10 && i < 150 && i % 3) {
+			sum += i;
+			++presentCount;
+		}
+	}
+	ASSERT_FALSE(dataSet.GetMetaData().GetFeatureInfo(0).CanBeMissed);
+	ASSERT_TRUE(dataSet.GetMetaData().GetFeatureInfo(1).CanBeMissed);
+	ASSERT_FALSE(dataSet.GetColumn(0).TracksMissing());
+	ASSERT_TRUE(dataSet.GetColumn(1).TracksMissing());
+
+	ASSERT_TRUE(dataSet.HasFeature(1, 1));
+	ASSERT_FALSE(dataSet.HasFeature(3, 1));
+	ASSERT_EQ(OBJECTS, dataSet.CountPresentFeatures(0, 0, OBJECTS));
+	ASSERT_EQ(presentCount, dataSet.CountPresentFeatures(1, 10, 140));
+	ASSERT_EQ(sum, dataSet.SumPresentFeatures(1, 10, 140));
+	ASSERT_EQ(0, dataSet.CountPresentFeatures(1, 3, 1));
+
+	dataSet.SwapObjects(0, 1);
+	ASSERT_TRUE(dataSet.HasFeature(0, 1));
+	ASSERT_FALSE(dataSet.HasFeature(1, 1));
+	dataSet.SetFeature(1, 1, 5.0);
+	ASSERT_TRUE(dataSet.HasFeature(1, 1));
+
+	DataSetWrapper wrapper(&dataSet);
+	ASSERT_TRUE(wrapper.HasFeature(1, 1));
+	ASSERT_FALSE(wrapper.HasFeature(3, 1));
+	ASSERT_EQ(dataSet.CountPresentFeatures(1, 0, OBJECTS), wrapper.CountPresentFeatures(1, 0, OBJECTS));
+	wrapper.SetFeature(2, 0, NaN);
+	ASSERT_FALSE(wrapper.HasFeature(2, 0));
+	ASSERT_TRUE(wrapper.HasFeature(1, 1));
+	ASSERT_EQ(OBJECTS - 1, wrapper.CountPresentFeatures(0, 0, OBJECTS));
+}
+
+TEST_F(DataSetTest, TypedColumnsTest)
+{
+	const int OBJECTS = 150;
+
+	std::vector<std::string> values;
+	for (int k = 0; k < 300; k++) {
+		values.push_back(ToString(k));
+	}
+
+	DataSet dataSet;
+	dataSet.GetMetaData().AddFeature(FeatureInfo("binary", Binary, true, std::vector<std::string>()));
+	dataSet.GetMetaData().AddFeature(FeatureInfo("small", Nominal, false,
+		std::vector<std::string>(values.begin(), values.begin() + 3)));
+	dataSet.GetMetaData().AddFeature(FeatureInfo("large", Nominal, false, values));
+	for (int i = 0; i < OBJECTS; i++) {
+		int objectIndex = dataSet.AddObject();
+		dataSet.SetFeature(objectIndex, 0, i % 4 == 0 ? NaN : i % 2);
+		dataSet.SetFeature(objectIndex, 1, i % 3);
+		dataSet.SetFeature(objectIndex, 2, i * 2);
+	}
+	ASSERT_EQ(BitColumn, dataSet.GetColumn(0).GetType());
+	ASSERT_EQ(UInt8Column, dataSet.GetColumn(1).GetType());
+	ASSERT_EQ(UInt16Column, dataSet.GetColumn(2).GetType());
+
+	std::vector<int> codes(OBJECTS);
+	std::vector<double> features(OBJECTS);
+	dataSet.GetFeatureCodes(0, 0, OBJECTS, &codes[0]);
+	dataSet.GetFeatures(0, 0, OBJECTS, &features[0]);
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(i % 4 == 0 ? -1 : i % 2, codes[i]);
+		ASSERT_EQ(i % 4 != 0, dataSet.HasFeature(i, 0));
+		if (i % 4 != 0) {
+			ASSERT_EQ(i % 2, features[i]);
+		}
+	}
+	ASSERT_EQ(OBJECTS / 2, dataSet.SumPresentFeatures(0, 0, OBJECTS));
+	dataSet.GetFeatureCodes(2, 0, OBJECTS, &codes[0]);
+	ASSERT_EQ(298, codes[149]);
+
+	int objectIndexes[] = { 5, 1, 7 };
+	int gatheredCodes[3];
+	dataSet.GatherFeatureCodes(1, objectIndexes, 3, gatheredCodes);
+	ASSERT_EQ(2, gatheredCodes[0]);
+	ASSERT_EQ(1, gatheredCodes[1]);
+	ASSERT_EQ(1, gatheredCodes[2]);
+
+	dataSet.SwapObjects(0, 1);
+	ASSERT_EQ(1.0, dataSet.GetFeature(0, 1));
+	ASSERT_FALSE(dataSet.HasFeature(1, 0));
+
+	// values which don't fit the type are stored as doubles
+	dataSet.SetFeature(3, 1, 0.5);
+	ASSERT_EQ(DoubleColumn, dataSet.GetColumn(1).GetType());
+	ASSERT_EQ(0.5, dataSet.GetFeature(3, 1));
+	ASSERT_EQ(1.0, dataSet.GetFeature(0, 1));
+	dataSet.SetFeature(3, 1, 0);
+	dataSet.CompactColumns();
+	ASSERT_EQ(UInt8Column, dataSet.GetColumn(1).GetType());
+	ASSERT_EQ(2.0, dataSet.GetFeature(2, 1));
+}
+
+TEST_F(DataSetTest, SinglePrecisionTest)
+{
+	const int OBJECTS = 100;
+
+	DataSet dataSet;
+	dataSet.SetSinglePrecision(false);
+	dataSet.Resize(OBJECTS, 2);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, 0.1 * i);
+		dataSet.SetFeature(i, 1, i % 10 ? i : NaN);
+	}
+	double sum = dataSet.SumPresentFeatures(1, 0, OBJECTS);
+
+	dataSet.SetSinglePrecision(true);
+	ASSERT_TRUE(dataSet.IsSinglePrecision());
+	ASSERT_EQ(FloatColumn, dataSet.GetColumn(0).GetType());
+	ASSERT_EQ(0, reinterpret_cast<size_t>(dataSet.GetColumn(0).GetFloatData()) % DefaultAlignment);
+	ASSERT_EQ(sum, dataSet.SumPresentFeatures(1, 0, OBJECTS));
+	ASSERT_FALSE(dataSet.HasFeature(10, 1));
+
+	std::vector<float> features(OBJECTS);
+	dataSet.GetFloatFeatures(0, 0, OBJECTS, &features[0]);
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(static_cast<float>(0.1 * i), features[i]);
+		ASSERT_EQ(static_cast<float>(0.1 * i), dataSet.GetFeature(i, 0));
+	}
+
+	DataSetWrapper wrapper(&dataSet);
+	int objectIndexes[] = { 20, 30, 31 };
+	wrapper.SetObjectIndexes(objectIndexes, objectIndexes + 3);
+	float gathered[3];
+	wrapper.GetFloatFeatures(1, 0, 3, gathered);
+	ASSERT_TRUE(IsNaN(gathered[0]));
+	ASSERT_EQ(31.0f, gathered[2]);
+
+	// new values are rounded, converting back to doubles is exact
+	dataSet.SetFeature(1, 0, 1.0 / 3);
+	ASSERT_EQ(static_cast<float>(1.0 / 3), dataSet.GetFeature(1, 0));
+	dataSet.SetSinglePrecision(false);
+	ASSERT_EQ(DoubleColumn, dataSet.GetColumn(0).GetType());
+	ASSERT_EQ(static_cast<float>(1.0 / 3), dataSet.GetFeature(1, 0));
+}
+
+TEST_F(DataSetTest, PermutationTest)
+{
+	Random random(2);
+	const int OBJECTS = 150;
+
+	int indexes[] = { 2, 0, 1, 3 };
+	Permutation permutation(indexes, indexes + 4);
+	ASSERT_FALSE(permutation.IsIdentity());
+	ASSERT_TRUE(permutation.Compose(permutation.Inverse()).IsIdentity());
+	ASSERT_EQ(1, permutation.Compose(permutation).Get(0));
+	int repeated[] = { 0, 0, 1 };
+	ASSERT_THROW(Permutation(repeated, repeated + 3), std::invalid_argument);
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.GetMetaData().AddFeature(FeatureInfo("binary", Binary, true, std::vector<std::string>()));
+	dataSet.GetMetaData().AddFeature(FeatureInfo("real", Numeric, true, std::vector<std::string>()));
+	for (int i = 0; i < OBJECTS; i++) {
+		int objectIndex = dataSet.AddObject();
+		dataSet.SetFeature(objectIndex, 0, i % 4 == 0 ? NaN : i % 2);
+		dataSet.SetFeature(objectIndex, 1, i % 5 == 0 ? NaN : (i * 7) % 11);
+		dataSet.SetTarget(objectIndex, i % 3 == 0);
+		dataSet.SetWeight(objectIndex, i);
+	}
+	sh_ptr< const std::vector<int> > sortedIndexes = dataSet.GetSortedObjectIndexes(1);
+
+	Permutation shuffle(OBJECTS);
+	shuffle.Shuffle(&random);
+	DataSet swapped(dataSet);
+	swapped.IDataSet::ApplyPermutation(shuffle);
+	dataSet.ApplyPermutation(shuffle);
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(swapped.GetTarget(i), dataSet.GetTarget(i));
+		ASSERT_EQ(swapped.GetWeight(i), dataSet.GetWeight(i));
+		ASSERT_EQ(swapped.HasFeature(i, 0), dataSet.HasFeature(i, 0));
+		ASSERT_EQ(swapped.HasFeature(i, 1), dataSet.HasFeature(i, 1));
+		for (int j = 0; j < 2; j++) {
+			if (dataSet.HasFeature(i, j)) {
+				ASSERT_EQ(swapped.GetFeature(i, j), dataSet.GetFeature(i, j));
+			}
+		}
+	}
+
+	// the cached order is renumbered
+	sh_ptr< const std::vector<int> > permutedIndexes = dataSet.GetSortedObjectIndexes(1);
+	ASSERT_NE(sortedIndexes.get(), permutedIndexes.get());
+	ASSERT_EQ(OBJECTS, static_cast<int>(permutedIndexes->size()));
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(shuffle.Get(permutedIndexes->at(i)), sortedIndexes->at(i));
+	}
+
+	// the wrapper reorders objects keeping custom values, the data is not changed
+	DataSetWrapper wrapper(&dataSet);
+	wrapper.SetWeight(0, 1000.0);
+	wrapper.Reverse();
+	ASSERT_EQ(1000.0, wrapper.GetWeight(OBJECTS - 1));
+	ASSERT_EQ(dataSet.GetTarget(0), wrapper.GetTarget(OBJECTS - 1));
+	ASSERT_EQ(dataSet.GetWeight(OBJECTS - 1), wrapper.GetWeight(0));
+	ASSERT_NE(1000.0, dataSet.GetWeight(0));
+	ASSERT_THROW(wrapper.ApplyPermutation(permutation), std::invalid_argument);
+}
+
+TEST_F(DataSetTest, KeySortingTest)
+{
+	Random random(3);
+	const int OBJECTS = 1000;
+
+	std::vector<double> keys(OBJECTS);
+	std::vector<int> codes(OBJECTS);
+	for (int i = 0; i < OBJECTS; i++) {
+		keys[i] = i % 17 == 0 ? NaN : (random.NextInt(200) - 100) * 1e-3 * (i % 3 ? 1.0 : 1e10);
+		codes[i] = random.NextInt(4) - 1;
+	}
+	keys[1] = -0.0;
+	keys[2] = 0.0;
+	keys[3] = -std::numeric_limits<double>::infinity();
+
+	for (int size = 10; size <= OBJECTS; size += OBJECTS - 10) {
+		for (int reverse = 0; reverse < 2; reverse++) {
+			Permutation permutation(size);
+			permutation.SortByKeys(&keys[0], reverse != 0);
+			for (int i = 1; i < size; i++) {
+				double key1 = keys[permutation.Get(i - 1)];
+				double key2 = keys[permutation.Get(i)];
+				if (IsNaN(key1)) {
+					ASSERT_TRUE(IsNaN(key2));
+				} else if (!IsNaN(key2)) {
+					ASSERT_TRUE(reverse ? key1 >= key2 : key1 <= key2);
+				}
+				if (key1 == key2 || (IsNaN(key1) && IsNaN(key2))) {
+					ASSERT_LT(permutation.Get(i - 1), permutation.Get(i));
+				}
+			}
+
+			permutation = Permutation(size);
+			permutation.SortByCodes(&codes[0], 3, reverse != 0);
+			for (int i = 1; i < size; i++) {
+				int code1 = codes[permutation.Get(i - 1)];
+				int code2 = codes[permutation.Get(i)];
+				ASSERT_TRUE(reverse ? code1 >= code2 : code1 <= code2);
+				if (code1 == code2) {
+					ASSERT_LT(permutation.Get(i - 1), permutation.Get(i));
+				}
+			}
+		}
+	}
+	Permutation permutation(OBJECTS);
+	ASSERT_THROW(permutation.SortByCodes(&codes[0], 2), std::out_of_range);
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	classes.push_back("2");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 1);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, keys[i]);
+		dataSet.SetTarget(i, i % 3);
+		dataSet.SetWeight(i, i);
+	}
+	dataSet.SortObjectsByTarget(true);
+	ASSERT_EQ(2, dataSet.GetTarget(0));
+	ASSERT_EQ(2.0, dataSet.GetWeight(0));
+	ASSERT_EQ(0, dataSet.GetTarget(OBJECTS - 1));
+	dataSet.SortObjectsByFeature(0);
+	ASSERT_EQ(3.0, dataSet.GetWeight(0));
+	ASSERT_TRUE(IsNaN(dataSet.GetFeature(OBJECTS - 1, 0)));
+	dataSet.SortObjectsByWeight(true);
+	ASSERT_EQ(OBJECTS - 1.0, dataSet.GetWeight(0));
+}
+
+TEST_F(DataSetTest, SnapshotTest)
+{
+	Random random(11);
+	const int OBJECTS = 2000;
+	const int FEATURES = 5;
+
+	DataSet dataSet;
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetWeight(i, random.NextDouble());
+		for (int j = 0; j < FEATURES; j++) {
+			dataSet.SetFeature(i, j, random.NextInt(50));
+		}
+	}
+	DataSetWrapper wrapper(&dataSet);
+	wrapper.SortObjectsByWeight();
+
+	sh_ptr<const DataSet> snapshot = DataSet::CreateSnapshot(wrapper);
+	ASSERT_EQ(OBJECTS, snapshot->GetObjectCount());
+	DataSet copy(wrapper);
+	std::vector< sh_ptr< const std::vector<int> > > sorted(FEATURES);
+	for (int j = 0; j < FEATURES; j++) {
+		sorted[j] = copy.GetSortedObjectIndexes(j);
+	}
+
+	// Any number of threads read the snapshot
+	std::vector<int> mismatches(16);
+	ThreadPool pool(4);
+	pool.ParallelFor(0, (int)mismatches.size(), SnapshotReader(snapshot.get(), &wrapper, sorted, &mismatches));
+	for (int t = 0; t < (int)mismatches.size(); t++) {
+		ASSERT_EQ(0, mismatches[t]);
+	}
+
+	// Copies of the snapshot can be changed
+	DataSet changed(*snapshot);
+	changed.SetFeature(0, 0, -1.0);
+	ASSERT_EQ(0, changed.GetSortedObjectIndexes(0)->at(0));
+}
@@ -1,13 +1,84 @@
 #include "dataset_wrapper.h"
 
+#include <algorithm>
 #include <stdexcept>
 
+#include "dataset.h"
 #include "util.h"
 
 using std::vector;
 
 namespace mll {
 
+namespace {
+
+//! Selects positions of the objects in the order of their original indices
+/*! originalOrder lists all original indices, objectIndexes maps positions
+    to original indices (may repeat them). Works in linear time.
+*/
+void FilterSortedIndexes(const vector<int>& originalOrder,
+                         const vector<int>& objectIndexes,
+                         vector<int>* sortedIndexes) {
+    vector<int> offsets(originalOrder.size() + 1);
+    for (int i = 0; i < static_cast<int>(objectIndexes.size()); ++i) {
+        ++offsets[objectIndexes[i] + 1];
+    }
+    for (int i = 1; i < static_cast<int>(offsets.size()); ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    vector<int> positions(objectIndexes.size());
+    vector<int> ends(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < static_cast<int>(objectIndexes.size()); ++i) {
+        positions[ends[objectIndexes[i]]++] = i;
+    }
+    sortedIndexes->clear();
+    sortedIndexes->reserve(objectIndexes.size());
+    for (vector<int>::const_iterator it = originalOrder.begin(); it != originalOrder.end(); ++it) {
+        sortedIndexes->insert(sortedIndexes->end(),
+                              positions.begin() + offsets[*it],
+                              positions.begin() + offsets[*it + 1]);
+    }
+}
+
+//! Composes index maps: result[i] = outer[inner[i]] (NULL map means the identity)
+sh_ptr< vector<int> > ComposeIndexes(const sh_ptr< vector<int> >& inner,
+                                     const sh_ptr< vector<int> >& outer) {
+    if (inner.get() == NULL) {
+        return outer;
+    } else if (outer.get() == NULL) {
+        return inner;
+    }
+    sh_ptr< vector<int> > indexes(new vector<int>(inner->size()));
+    for (int i = 0; i < static_cast<int>(inner->size()); ++i) {
+        indexes->at(i) = outer->at(inner->at(i));
+    }
+    return indexes;
+}
+
+//! Moves values to the new positions of objects (values without old positions are default)
+template<typename T>
+void MoveValues(const vector<int>& oldPositions, vector<T>* values) {
+    vector<T> newValues(oldPositions.size());
+    for (int i = 0; i < static_cast<int>(oldPositions.size()); ++i) {
+        if (oldPositions[i] >= 0) {
+            newValues[i] = values->at(oldPositions[i]);
+        }
+    }
+    values->swap(newValues);
+}
+
+} // namespace
+
+DataSetWrapper::~DataSetWrapper() {
+    if (parentWrapper_ != NULL) {
+        parentWrapper_->RemoveChild(this);
+    }
+    std::lock_guard<std::mutex> lock(childrenMutex_);
+    for (vector<DataSetWrapper*>::iterator it = children_.begin(); it != children_.end(); ++it) {
+        (*it)->parentWrapper_ = NULL;
+    }
+}
+
 void DataSetWrapper::SetMetaData(const IMetaData* metaData) {
     metaData_.reset(new MetaDataWrapper(metaData));  
     if (featureIndexes_.get() != NULL) {
@@ -15,68 +86,465 @@ void DataSetWrapper::SetMetaData(const IMetaData* metaData) {
     }
 }
 
+void DataSetWrapper::GetFeatures(int featureIndex, int objectIndex, int count, double* features) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GetFeatures(featureIndex, objectIndex, count, features);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        source_->GatherFeatures(GetSourceFeatureIndex(featureIndex),
+                                GetSourceObjectIndexes(objectIndex, count), count, features);
+    } else {
+        source_->GetFeatures(GetSourceFeatureIndex(featureIndex), objectIndex, count, features);
+    }
+}
+
+void DataSetWrapper::GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GatherFeatures(featureIndex, objectIndexes, count, features);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        vector<int> sourceIndexes;
+        source_->GatherFeatures(GetSourceFeatureIndex(featureIndex),
+                                GetSourceObjectIndexes(objectIndexes, count, &sourceIndexes), count, features);
+    } else {
+        source_->GatherFeatures(GetSourceFeatureIndex(featureIndex), objectIndexes, count, features);
+    }
+}
+
+void DataSetWrapper::GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GetFloatFeatures(featureIndex, objectIndex, count, features);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        source_->GatherFloatFeatures(GetSourceFeatureIndex(featureIndex),
+                                     GetSourceObjectIndexes(objectIndex, count), count, features);
+    } else {
+        source_->GetFloatFeatures(GetSourceFeatureIndex(featureIndex), objectIndex, count, features);
+    }
+}
+
+void DataSetWrapper::GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GatherFloatFeatures(featureIndex, objectIndexes, count, features);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        vector<int> sourceIndexes;
+        source_->GatherFloatFeatures(GetSourceFeatureIndex(featureIndex),
+                                     GetSourceObjectIndexes(objectIndexes, count, &sourceIndexes), count, features);
+    } else {
+        source_->GatherFloatFeatures(GetSourceFeatureIndex(featureIndex), objectIndexes, count, features);
+    }
+}
+
+void DataSetWrapper::GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GetFeatureCodes(featureIndex, objectIndex, count, codes);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        source_->GatherFeatureCodes(GetSourceFeatureIndex(featureIndex),
+                                    GetSourceObjectIndexes(objectIndex, count), count, codes);
+    } else {
+        source_->GetFeatureCodes(GetSourceFeatureIndex(featureIndex), objectIndex, count, codes);
+    }
+}
+
+void DataSetWrapper::GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        IDataSet::GatherFeatureCodes(featureIndex, objectIndexes, count, codes);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        vector<int> sourceIndexes;
+        source_->GatherFeatureCodes(GetSourceFeatureIndex(featureIndex),
+                                    GetSourceObjectIndexes(objectIndexes, count, &sourceIndexes), count, codes);
+    } else {
+        source_->GatherFeatureCodes(GetSourceFeatureIndex(featureIndex), objectIndexes, count, codes);
+    }
+}
+
+void DataSetWrapper::GetTargets(int objectIndex, int count, int* targets) const {
+    UpdateSource();
+    if (targets_.get() != NULL) {
+        IDataSet::GetTargets(objectIndex, count, targets);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        source_->GatherTargets(GetSourceObjectIndexes(objectIndex, count), count, targets);
+    } else {
+        source_->GetTargets(objectIndex, count, targets);
+    }
+}
+
+void DataSetWrapper::GatherTargets(const int* objectIndexes, int count, int* targets) const {
+    UpdateSource();
+    if (targets_.get() != NULL) {
+        IDataSet::GatherTargets(objectIndexes, count, targets);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        vector<int> sourceIndexes;
+        source_->GatherTargets(GetSourceObjectIndexes(objectIndexes, count, &sourceIndexes), count, targets);
+    } else {
+        source_->GatherTargets(objectIndexes, count, targets);
+    }
+}
+
+void DataSetWrapper::GetWeights(int objectIndex, int count, double* weights) const {
+    UpdateSource();
+    if (weights_.get() != NULL) {
+        IDataSet::GetWeights(objectIndex, count, weights);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        source_->GatherWeights(GetSourceObjectIndexes(objectIndex, count), count, weights);
+    } else {
+        source_->GetWeights(objectIndex, count, weights);
+    }
+}
+
+void DataSetWrapper::GatherWeights(const int* objectIndexes, int count, double* weights) const {
+    UpdateSource();
+    if (weights_.get() != NULL) {
+        IDataSet::GatherWeights(objectIndexes, count, weights);
+    } else if (sourceObjectIndexes_.get() != NULL) {
+        vector<int> sourceIndexes;
+        source_->GatherWeights(GetSourceObjectIndexes(objectIndexes, count, &sourceIndexes), count, weights);
+    } else {
+        source_->GatherWeights(objectIndexes, count, weights);
+    }
+}
+
+int DataSetWrapper::CountPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL || sourceObjectIndexes_.get() != NULL) {
+        return IDataSet::CountPresentFeatures(featureIndex, objectIndex, count);
+    } else {
+        return source_->CountPresentFeatures(GetSourceFeatureIndex(featureIndex), objectIndex, count);
+    }
+}
+
+double DataSetWrapper::SumPresentFeatures(int featureIndex, int objectIndex, int count) const {
+    UpdateSource();
+    if (GetFeatureOverlay(featureIndex) != NULL || sourceObjectIndexes_.get() != NULL) {
+        return IDataSet::SumPresentFeatures(featureIndex, objectIndex, count);
+    } else {
+        return source_->SumPresentFeatures(GetSourceFeatureIndex(featureIndex), objectIndex, count);
+    }
+}
+
+sh_ptr< const vector<int> > DataSetWrapper::GetSortedObjectIndexes(int featureIndex) const {
+    if (GetFeatureOverlay(featureIndex) != NULL) {
+        return IDataSet::GetSortedObjectIndexes(featureIndex);
+    } else if (objectIndexes_.get() == NULL) {
+        // shares the order cached by the original data
+        return dataSet_->GetSortedObjectIndexes(GetActualFeatureIndex(featureIndex));
+    }
+    UpdateSource();
+    sh_ptr< const vector<int> > originalOrder =
+        source_->GetSortedObjectIndexes(GetSourceFeatureIndex(featureIndex));
+    std::lock_guard<std::mutex> lock(sourceMutex_);
+    if (static_cast<int>(sortedIndexes_.size()) != GetFeatureCount()) {
+        sortedIndexes_.clear();
+        sortedIndexes_.resize(GetFeatureCount());
+    }
+    SortedIndexes& cached = sortedIndexes_.at(featureIndex);
+    if (cached.Original.get() != originalOrder.get()) {
+        vector<int>* indexes = new vector<int>();
+        sh_ptr< const vector<int> > sortedIndexes(indexes);
+        FilterSortedIndexes(*originalOrder, *sourceObjectIndexes_, indexes);
+        cached.Indexes = sortedIndexes;
+        cached.Original = originalOrder;
+    }
+    return cached.Indexes;
+}
+
+const int* DataSetWrapper::GetSourceObjectIndexes(int objectIndex, int count) const {
+    if (count < 0 || objectIndex < 0 || objectIndex > GetObjectCount() - count) {
+        throw std::out_of_range("Indexes was out of range");
+    }
+    return count > 0 ? &sourceObjectIndexes_->at(objectIndex) : NULL;
+}
+
+const int* DataSetWrapper::GetSourceObjectIndexes(const int* objectIndexes, int count, vector<int>* sourceIndexes) const {
+    sourceIndexes->resize(count);
+    for (int i = 0; i < count; ++i) {
+        sourceIndexes->at(i) = sourceObjectIndexes_->at(objectIndexes[i]);
+    }
+    return count > 0 ? &sourceIndexes->at(0) : NULL;
+}
+
+void DataSetWrapper::ComposeSource() const {
+    std::lock_guard<std::mutex> lock(sourceMutex_);
+    if (isSourceUpdated_.load(std::memory_order_relaxed)) {
+        // composed by another thread meanwhile
+        return;
+    }
+    if (parentWrapper_ != NULL && parentWrapper_->IsIndexView()) {
+        parentWrapper_->UpdateSource();
+        source_ = parentWrapper_->source_;
+        sourceObjectIndexes_ = ComposeIndexes(objectIndexes_, parentWrapper_->sourceObjectIndexes_);
+        sourceFeatureIndexes_ = ComposeIndexes(featureIndexes_, parentWrapper_->sourceFeatureIndexes_);
+    } else {
+        source_ = dataSet_;
+        sourceObjectIndexes_ = objectIndexes_;
+        sourceFeatureIndexes_ = featureIndexes_;
+    }
+    sortedIndexes_.clear();
+    isSourceUpdated_.store(true, std::memory_order_release);
+}
+
+void DataSetWrapper::AddChild(DataSetWrapper* child) const {
+    std::lock_guard<std::mutex> lock(childrenMutex_);
+    children_.push_back(child);
+}
+
+void DataSetWrapper::RemoveChild(DataSetWrapper* child) const {
+    std::lock_guard<std::mutex> lock(childrenMutex_);
+    vector<DataSetWrapper*>::iterator it = std::find(children_.begin(), children_.end(), child);
+    if (it != children_.end()) {
+        children_.erase(it);
+    }
+}
+
+void DataSetWrapper::InvalidateChildren() {
+    std::lock_guard<std::mutex> lock(childrenMutex_);
+    for (vector<DataSetWrapper*>::iterator it = children_.begin(); it != children_.end(); ++it) {
+        (*it)->UpdateRevision();
+    }
+}
+
+void DataSetWrapper::SwapObjects(int objectIndex1, int objectIndex2) {
+    CreateObjectIndexes();
+    std::swap(objectIndexes_->at(objectIndex1), objectIndexes_->at(objectIndex2));
+    for (int j = 0; j < static_cast<int>(featureOverlays_.size()); ++j) {
+        if (featureOverlays_[j].get() != NULL) {
+            std::swap(featureOverlays_[j]->at(objectIndex1), featureOverlays_[j]->at(objectIndex2));
+        }
+    }
+    if (targets_.get() != NULL) {
+        std::swap(targets_->at(objectIndex1), targets_->at(objectIndex2));
+    }
+    if (weights_.get() != NULL) {
+        std::swap(weights_->at(objectIndex1), weights_->at(objectIndex2));
+    }
+    if (confidences_.get() != NULL) {
+        confidences_->at(objectIndex1).swap(confidences_->at(objectIndex2));
+    }
+    sortedIndexes_.clear();
+    // keeps the composed indices valid instead of rebuilding them after every swap
+    if (isSourceUpdated_ && sourceObjectIndexes_.get() != objectIndexes_.get()) {
+        std::swap(sourceObjectIndexes_->at(objectIndex1), sourceObjectIndexes_->at(objectIndex2));
+    }
+    InvalidateChildren();
+}
+
+void DataSetWrapper::ApplyPermutation(const Permutation& permutation) {
+    if (permutation.GetSize() != GetObjectCount()) {
+        throw std::invalid_argument("Permutation size doesn't match the number of objects");
+    }
+    const vector<int>& positions = permutation.GetIndexes();
+    sh_ptr< vector<int> > objectIndexes(new vector<int>(positions.size()));
+    for (int i = 0; i < static_cast<int>(positions.size()); ++i) {
+        objectIndexes->at(i) = GetActualObjectIndex(positions[i]);
+    }
+    for (int j = 0; j < static_cast<int>(featureOverlays_.size()); ++j) {
+        if (featureOverlays_[j].get() != NULL) {
+            MoveValues(positions, featureOverlays_[j].get());
+        }
+    }
+    if (targets_.get() != NULL) {
+        MoveValues(positions, targets_.get());
+    }
+    if (weights_.get() != NULL) {
+        MoveValues(positions, weights_.get());
+    }
+    if (confidences_.get() != NULL) {
+        MoveValues(positions, confidences_.get());
+    }
+    objectIndexes_ = objectIndexes;
+    sortedIndexes_.clear();
+    UpdateRevision();
+}
+
 void DataSetWrapper::SetObjectIndexes(sh_ptr< vector<int> > objectIndexes) {
-    for (vector<int>::const_iterator it = objectIndexes->begin(); it != objectIndexes->end(); ++it) {
-        if (*it < 0 || *it >= dataSet_->GetObjectCount()) {
-            throw std::out_of_range("Indexes was out of range");
+    if (objectIndexes.get() == NULL && objectIndexes_.get() == NULL) {
+        // the original objects set and order is kept
+        return;
+    }
+    int objectCount = dataSet_->GetObjectCount();
+    if (objectIndexes.get() != NULL) {
+        for (vector<int>::const_iterator it = objectIndexes->begin(); it != objectIndexes->end(); ++it) {
+            if (*it < 0 || *it >= objectCount) {
+                throw std::out_of_range("Indexes was out of range");
+            }
+        }
+        objectCount = objectIndexes->size();
+    }
+    if (!IsIndexView()) {
+        // moving custom values to the new positions of the objects
+        vector<int> positions(dataSet_->GetObjectCount(), -1);
+        for (int i = 0; i < GetObjectCount(); ++i) {
+            positions[GetActualObjectIndex(i)] = i;
+        }
+        vector<int> actualIndexes;
+        if (objectIndexes.get() != NULL) {
+            actualIndexes = *objectIndexes;
+        } else {
+            InitIndexes(objectCount, &actualIndexes);
+        }
+        vector<int> oldPositions(objectCount);
+        for (int i = 0; i < objectCount; ++i) {
+            oldPositions[i] = positions[actualIndexes[i]];
+        }
+        for (int j = 0; j < static_cast<int>(featureOverlays_.size()); ++j) {
+            if (featureOverlays_[j].get() != NULL) {
+                MoveValues(oldPositions, featureOverlays_[j].get());
+                for (int i = 0; i < objectCount; ++i) {
+                    if (oldPositions[i] < 0) {
+                        featureOverlays_[j]->at(i) = dataSet_->GetFeature(actualIndexes[i], j);
+                    }
+                }
+            }
+        }
+        if (targets_.get() != NULL) {
+            MoveValues(oldPositions, targets_.get());
+            for (int i = 0; i < objectCount; ++i) {
+                if (oldPositions[i] < 0) {
+                    targets_->at(i) = dataSet_->GetTarget(actualIndexes[i]);
+                }
+            }
+        }
+        if (weights_.get() != NULL) {
+            MoveValues(oldPositions, weights_.get());
+            for (int i = 0; i < objectCount; ++i) {
+                if (oldPositions[i] < 0) {
+                    weights_->at(i) = dataSet_->GetWeight(actualIndexes[i]);
+                }
+            }
+        }
+        if (confidences_.get() != NULL) {
+            MoveValues(oldPositions, confidences_.get());
+            for (int i = 0; i < objectCount; ++i) {
+                if (oldPositions[i] < 0) {
+                    confidences_->at(i).resize(GetClassCount());
+                    for (int j = 0; j < GetClassCount(); ++j) {
+                        confidences_->at(i).at(j) = dataSet_->GetConfidence(actualIndexes[i], j);
+                    }
+                }
+            }
         }
     }
     objectIndexes_ = objectIndexes;
+    sortedIndexes_.clear();
+    UpdateRevision();
+}
+
+void DataSetWrapper::Compact() {
+    if (HasConfidences()) {
+        // the dataset doesn't copy confidences, they are kept as custom values
+        CreateConfidences();
+    }
+    // custom values and indices are copied to the compacted data
+    sh_ptr<IDataSet> compactDataSet(new DataSet(*this));
+    metaData_.reset();
+    featureIndexes_ = sh_ptr< vector<int> >();
+    objectIndexes_ = sh_ptr< vector<int> >();
+    featureOverlays_.clear();
+    targets_.reset();
+    weights_.reset();
+    compactDataSet_ = compactDataSet;
+    dataSet_ = compactDataSet_.get();
+    if (parentWrapper_ != NULL) {
+        parentWrapper_->RemoveChild(this);
+        parentWrapper_ = NULL;
+    }
+    sortedIndexes_.clear();
+    UpdateRevision();
+}
+
+bool DataSetWrapper::CompactForPasses(int passCount, int compactPassCount /*= DefaultCompactPassCount*/) {
+    if (passCount < compactPassCount) {
+        return false;
+    }
+    UpdateSource();
+    if (sourceObjectIndexes_.get() == NULL && dynamic_cast<const DataSet*>(source_) != NULL) {
+        // values are already read sequentially
+        return false;
+    }
+    Compact();
+    return true;
 }
 
 void DataSetWrapper::SetFeatureIndexes(sh_ptr< vector<int> > featureIndexes) {
     CreateMetaData();
     metaData_->SetFeatureIndexes(featureIndexes);
     featureIndexes_ = featureIndexes;
+    UpdateRevision();
 }
 
+bool DataSetWrapper::IsIndexView() const {
+    if (targets_.get() != NULL || weights_.get() != NULL || confidences_.get() != NULL) {
+        return false;
+    }
+    for (int j = 0; j < static_cast<int>(featureOverlays_.size()); ++j) {
+        if (featureOverlays_[j].get() != NULL) {
+            return false;
+        }
+    }
+    return true;
+}
 
-void DataSetWrapper::CreateFeatures() {
-    if (features_.get() == NULL) {
-        features_.reset(new vector< vector<double> >(dataSet_->GetObjectCount()));
-        for (int i = 0; i < static_cast<int>(features_->size()); ++i) {
-            features_->at(i).resize(dataSet_->GetFeatureCount());
-            for (int j = 0; j < static_cast<int>(features_->at(i).size()); ++j) {
-                features_->at(i).at(j) = dataSet_->GetFeature(i, j);
-            }
+vector<double>* DataSetWrapper::CreateFeatureOverlay(int featureIndex) {
+    int actualIndex = GetActualFeatureIndex(featureIndex);
+    if (static_cast<int>(featureOverlays_.size()) < dataSet_->GetFeatureCount()) {
+        featureOverlays_.resize(dataSet_->GetFeatureCount());
+    }
+    sh_ptr< vector<double> >& overlay = featureOverlays_.at(actualIndex);
+    if (overlay.get() == NULL) {
+        sh_ptr< vector<double> > features(new vector<double>(GetObjectCount()));
+        if (!features->empty()) {
+            GetFeatures(featureIndex, 0, GetObjectCount(), &features->at(0));
         }
+        overlay = features;
+        UpdateRevision();
     }
+    return overlay.get();
 }
 
 void DataSetWrapper::CreateTargets() {
     if (targets_.get() == NULL) {
-        targets_.reset(new vector<int>(dataSet_->GetObjectCount()));
-        for (int i = 0; i < static_cast<int>(targets_->size()); ++i) {
-            targets_->at(i) = dataSet_->GetTarget(i);
+        std::auto_ptr< vector<int> > targets(new vector<int>(GetObjectCount()));
+        if (!targets->empty()) {
+            GetTargets(0, GetObjectCount(), &targets->at(0));
         }
+        targets_ = targets;
+        UpdateRevision();
     }
 }
 
 void DataSetWrapper::CreateWeights() {
     if (weights_.get() == NULL) {
-        weights_.reset(new vector<double>(dataSet_->GetObjectCount()));
-        for (int i = 0; i < static_cast<int>(weights_->size()); ++i) {
-            weights_->at(i) = dataSet_->GetWeight(i);
+        std::auto_ptr< vector<double> > weights(new vector<double>(GetObjectCount()));
+        if (!weights->empty()) {
+            GetWeights(0, GetObjectCount(), &weights->at(0));
         }
+        weights_ = weights;
+        UpdateRevision();
     }
 }
 
 void DataSetWrapper::CreateConfidences() {
     if (confidences_.get() == NULL) {
-        confidences_.reset(new vector< vector<double> >(dataSet_->GetObjectCount()));
-        for (int i = 0; i < static_cast<int>(features_->size()); ++i) {
-            confidences_->at(i).resize(dataSet_->GetClassCount());
-            for (int j = 0; j < static_cast<int>(features_->at(i).size()); ++j) {
-                confidences_->at(i).at(j) = dataSet_->GetConfidence(i, j);
+        std::auto_ptr< vector< vector<double> > > confidences(
+            new vector< vector<double> >(GetObjectCount(), vector<double>(GetClassCount())));
+        for (int i = 0; i < static_cast<int>(confidences->size()); ++i) {
+            for (int j = 0; j < GetClassCount(); ++j) {
+                confidences->at(i).at(j) = GetConfidence(i, j);
             }
         }
+        confidences_ = confidences;
+        UpdateRevision();
     }
 }
 
 void DataSetWrapper::CreateObjectIndexes() {
     if (objectIndexes_.get() == NULL) {
-        objectIndexes_.set(new vector<int>());
+        objectIndexes_ = sh_ptr< vector<int> >(new vector<int>());
         InitIndexes(dataSet_->GetObjectCount(), objectIndexes_.get());
+        UpdateRevision();
     }
 }
 
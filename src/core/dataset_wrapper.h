@@ -1,6 +1,8 @@
 #ifndef DATASET_WRAPPER_H_
 #define DATASET_WRAPPER_H_
 
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 
 #include "data.h"
@@ -8,27 +10,54 @@
 
 namespace mll {
 
+//! Number of passes over the data which pays for copying it to a dense dataset
+const int DefaultCompactPassCount = 3;
+
 //! Wrapper for dataset. Implements IDataSet.
-/*! Can change some data properties (such as weights, targets, objects and 
+/*! Can change some data properties (such as weights, targets, objects and
     features set and order) while the original data keeps constant.
+    Custom values are kept in overlays indexed by the positions of objects in
+    the wrapper: only the changed feature columns (or targets, weights and
+    confidences) are copied, other ones are read from the original data.
+    Wrapper of another wrapper composes their object and feature indices and
+    reads the data directly from the first wrapped data which is not a plain
+    index view, so the access cost doesn't depend on the number of wrappers.
+    The composed indices are rebuilt on the first access after the wrapper or
+    any wrapper it's built on changed its indices or created custom values
+    (changes of a wrapper don't touch the wrappers it's built on).
+    Thread safety: const methods can be called concurrently while nobody
+    changes the wrapper and the data under it, the composed indices and cached
+    orders are built once under a lock. Several threads can build and change
+    their own wrappers of one shared wrapper or dataset.
 */
 class DataSetWrapper: public IDataSet {
 public:
     //! Default initialization with the original data
     DataSetWrapper(const IDataSet* dataSet)
-        : dataSet_(dataSet) {
+        : dataSet_(dataSet),
+          parentWrapper_(dynamic_cast<const DataSetWrapper*>(dataSet)),
+          source_(dataSet),
+          isSourceUpdated_(false) {
         if (dataSet == NULL) {
             throw std::logic_error("DataSet cannot be null");
         }
+        if (parentWrapper_ != NULL) {
+            parentWrapper_->AddChild(this);
+        }
     }
 
+    //! Detaches the wrapper from the wrapped one and from the wrappers built on it
+    virtual ~DataSetWrapper();
+
     //! Restores all properties to their original values
     void Reset() {
         metaData_.reset();
-        featureIndexes_ = sh_ptr< std::vector<int> >();
-        ResetObjectIndexes();
+        ResetFeatures();
         ResetWeights();
         ResetTargets();
+        ResetConfidences();
+        featureIndexes_ = sh_ptr< std::vector<int> >();
+        ResetObjectIndexes();
     }
 
     void ResetMetaData() {
@@ -43,18 +72,32 @@ public:
             metaData_->Reset();
         }
         featureIndexes_ = sh_ptr< std::vector<int> >();
+        UpdateRevision();
     }
 
+    //! Restores original objects set and order (custom values are kept for the objects)
     void ResetObjectIndexes() {
-        objectIndexes_ = sh_ptr< std::vector<int> >();
+        SetObjectIndexes(sh_ptr< std::vector<int> >());
+    }
+
+    void ResetFeatures() {
+        featureOverlays_.clear();
+        UpdateRevision();
     }
 
     void ResetWeights() {
         weights_.reset();
+        UpdateRevision();
     }
 
     void ResetTargets() {
         targets_.reset();
+        UpdateRevision();
+    }
+
+    void ResetConfidences() {
+        confidences_.reset();
+        UpdateRevision();
     }
 
     //! Gets metadata about the dataset
@@ -77,45 +120,47 @@ public:
 
     //! Returns false if the feature value for the object is missed
     virtual bool HasFeature(int objectIndex, int featureIndex) const {
-        if (features_.get() != NULL) {
-            return IsNaN(features_->at(
-                GetActualObjectIndex(objectIndex)).at(
-                GetActualFeatureIndex(featureIndex)));
+        const std::vector<double>* overlay = GetFeatureOverlay(featureIndex);
+        if (overlay != NULL) {
+            return !IsNaN(overlay->at(objectIndex));
         } else {
-            return dataSet_->HasFeature(
-                GetActualObjectIndex(objectIndex),
-                GetActualFeatureIndex(featureIndex));
+            UpdateSource();
+            return source_->HasFeature(
+                GetSourceObjectIndex(objectIndex),
+                GetSourceFeatureIndex(featureIndex));
         }
     }
 
     //! Gets the object's value of the feature
     virtual double GetFeature(int objectIndex, int featureIndex) const {
-        if (features_.get() != NULL) {
-            return features_->at(
-                GetActualObjectIndex(objectIndex)).at(
-                GetActualFeatureIndex(featureIndex));
+        const std::vector<double>* overlay = GetFeatureOverlay(featureIndex);
+        if (overlay != NULL) {
+            return overlay->at(objectIndex);
         } else {
-            return dataSet_->GetFeature(
-                GetActualObjectIndex(objectIndex),
-                GetActualFeatureIndex(featureIndex));
+            UpdateSource();
+            return source_->GetFeature(
+                GetSourceObjectIndex(objectIndex),
+                GetSourceFeatureIndex(featureIndex));
         }
     }
 
     //! Gets the object's value of the target feature
     virtual int GetTarget(int objectIndex) const {
         if (targets_.get() != NULL) {
-            return targets_->at(GetActualObjectIndex(objectIndex));
+            return targets_->at(objectIndex);
         } else {
-            return dataSet_->GetTarget(GetActualObjectIndex(objectIndex));
+            UpdateSource();
+            return source_->GetTarget(GetSourceObjectIndex(objectIndex));
         }
     }
 
     //! Gets the object's weight
     virtual double GetWeight(int objectIndex) const {
         if (weights_.get() != NULL) {
-            return weights_->at(GetActualObjectIndex(objectIndex));
+            return weights_->at(objectIndex);
         } else {
-            return dataSet_->GetWeight(GetActualObjectIndex(objectIndex));
+            UpdateSource();
+            return source_->GetWeight(GetSourceObjectIndex(objectIndex));
         }
     }
 
@@ -127,28 +172,56 @@ public:
     //! Gets the object classification confidence for the target
     virtual double GetConfidence(int objectIndex, int target) const {
         if (confidences_.get() != NULL) {
-            return confidences_->at(GetActualObjectIndex(objectIndex)).at(target);
+            return confidences_->at(objectIndex).at(target);
         } else {
-            return dataSet_->GetConfidence(GetActualObjectIndex(objectIndex), target);
+            UpdateSource();
+            return source_->GetConfidence(GetSourceObjectIndex(objectIndex), target);
         }
     }
 
+    //! Gets the feature values of count objects starting from objectIndex
+    virtual void GetFeatures(int featureIndex, int objectIndex, int count, double* features) const;
+    //! Gets the feature values of the listed objects
+    virtual void GatherFeatures(int featureIndex, const int* objectIndexes, int count, double* features) const;
+    //! Gets the targets of count objects starting from objectIndex
+    virtual void GetTargets(int objectIndex, int count, int* targets) const;
+    //! Gets the targets of the listed objects
+    virtual void GatherTargets(const int* objectIndexes, int count, int* targets) const;
+    //! Gets the weights of count objects starting from objectIndex
+    virtual void GetWeights(int objectIndex, int count, double* weights) const;
+    //! Gets the weights of the listed objects
+    virtual void GatherWeights(const int* objectIndexes, int count, double* weights) const;
+    //! Gets the feature values of count objects starting from objectIndex as floats
+    virtual void GetFloatFeatures(int featureIndex, int objectIndex, int count, float* features) const;
+    //! Gets the feature values of the listed objects as floats
+    virtual void GatherFloatFeatures(int featureIndex, const int* objectIndexes, int count, float* features) const;
+    //! Gets the feature values of count objects starting from objectIndex as integer codes
+    virtual void GetFeatureCodes(int featureIndex, int objectIndex, int count, int* codes) const;
+    //! Gets the feature values of the listed objects as integer codes
+    virtual void GatherFeatureCodes(int featureIndex, const int* objectIndexes, int count, int* codes) const;
+    //! Counts objects which have the feature value among count objects starting from objectIndex
+    virtual int CountPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Sums present feature values of count objects starting from objectIndex
+    virtual double SumPresentFeatures(int featureIndex, int objectIndex, int count) const;
+    //! Gets indices of all objects ordered by the feature value
+    /*! The order is taken from the original data, for a subset of objects
+        it's filtered in linear time instead of sorting (and cached).
+    */
+    virtual sh_ptr< const std::vector<int> > GetSortedObjectIndexes(int featureIndex) const;
+
     //! Sets metadata
     void SetMetaData(const IMetaData* metaData);
 
-    //! Sets the object's value of the feature
+    //! Sets the object's value of the feature (copies only values of this feature)
     virtual void SetFeature(int objectIndex, int featureIndex, double feature) {
-        CreateFeatures();
-        features_->at(
-            GetActualObjectIndex(objectIndex)).at(
-            GetActualFeatureIndex(featureIndex)) = feature;
+        CreateFeatureOverlay(featureIndex)->at(objectIndex) = feature;
     }
-    
+
     //! Sets the object's value of the target feature
     virtual void SetTarget(int objectIndex, int target) {
         if (target >= 0 && target < GetClassCount() || target == Refuse) {
             CreateTargets();
-            targets_->at(GetActualObjectIndex(objectIndex)) = target;
+            targets_->at(objectIndex) = target;
         }
     }
 
@@ -156,7 +229,7 @@ public:
     virtual void SetWeight(int objectIndex, double weight) {
         if (weight >= 0) {
             CreateWeights();
-            weights_->at(GetActualObjectIndex(objectIndex)) = weight;
+            weights_->at(objectIndex) = weight;
         }
     }
 
@@ -164,29 +237,58 @@ public:
     virtual void SetConfidence(int objectIndex, int target, double confidence) {
         if (confidence >= 0) {
             CreateConfidences();
-            confidences_->at(GetActualObjectIndex(objectIndex)).at(target) = confidence;
+            confidences_->at(objectIndex).at(target) = confidence;
         }
     }
 
     //! Swaps two objects
-    virtual void SwapObjects(int objectIndex1, int objectIndex2) {
-        CreateObjectIndexes();
-        std::swap(objectIndexes_->at(objectIndex1), objectIndexes_->at(objectIndex2));
-    }
+    virtual void SwapObjects(int objectIndex1, int objectIndex2);
+    //! Reorders the objects by one index list (the wrapped data is not changed)
+    virtual void ApplyPermutation(const Permutation& permutation);
 
     //! Sets subset (list) of object indices. Useful for testing.
+    /*! Custom values are kept for the objects which remain in the wrapper.
+    */
     template<typename TIter>
     void SetObjectIndexes(TIter first, TIter last) {
         SetObjectIndexes(sh_ptr< std::vector<int> >(new std::vector<int>(first, last)));
     }
 
+    //! Sets subset (list) of object indices (NULL for all objects), moves custom values
+    /*! The wrapper takes the list instead of copying it, it must not be changed by others.
+    */
+    void SetObjectIndexes(sh_ptr< std::vector<int> > objectIndexes);
+
     //! Sets subset (list) of feature indices. Useful for feature selection.
     template<typename TIter>
     void SetFeatureIndexes(TIter first, TIter last) {
         SetFeatureIndexes(sh_ptr< std::vector<int> >(new std::vector<int>(first, last)));
     }
-    
+
+    //! Copies the objects and features of the wrapper to a dense dataset owned by the wrapper
+    /*! The values are read sequentially afterwards instead of gathering them
+        from the original data. The wrapper doesn't refer to the original data
+        any more: indices set later are indices of the compacted objects and
+        features, changes of the original data are not seen.
+    */
+    void Compact();
+
+    //! Compacts the wrapper if its values are gathered and passCount reaches compactPassCount
+    /*! Learners which read the data many times call it with the number of
+        passes they are going to make. Returns true if the wrapper was compacted.
+    */
+    bool CompactForPasses(int passCount, int compactPassCount = DefaultCompactPassCount);
+
 private:
+    DataSetWrapper(const DataSetWrapper&);
+    DataSetWrapper& operator=(const DataSetWrapper&);
+
+    //! Order of objects by a feature and the order in the original data it was filtered from
+    struct SortedIndexes {
+        sh_ptr< const std::vector<int> > Original;  //!< Order of objects in the original data
+        sh_ptr< const std::vector<int> > Indexes;   //!< Order of objects in the wrapper
+    };
+
     //! Gets index of the object in the original data by its index in the wrapper
     int GetActualObjectIndex(int objectIndex) const {
         if (objectIndexes_.get() != NULL) {
@@ -205,13 +307,70 @@ private:
         }
     }
 
-    //! Sets subset (list) of object indices
-    void SetObjectIndexes(sh_ptr< std::vector<int> > objectIndexes);
+    //! Gets custom values of the feature (NULL if they are not set)
+    const std::vector<double>* GetFeatureOverlay(int featureIndex) const {
+        int actualIndex = GetActualFeatureIndex(featureIndex);
+        if (actualIndex < static_cast<int>(featureOverlays_.size())) {
+            return featureOverlays_[actualIndex].get();
+        } else {
+            return NULL;
+        }
+    }
+
+    //! Gets index of the object in the source data
+    int GetSourceObjectIndex(int objectIndex) const {
+        if (sourceObjectIndexes_.get() != NULL) {
+            return sourceObjectIndexes_->at(objectIndex);
+        } else {
+            return objectIndex;
+        }
+    }
+
+    //! Gets index of the feature in the source data
+    int GetSourceFeatureIndex(int featureIndex) const {
+        if (sourceFeatureIndexes_.get() != NULL) {
+            return sourceFeatureIndexes_->at(featureIndex);
+        } else {
+            return featureIndex;
+        }
+    }
+
+    //! Gets indices in the source data of count objects starting from objectIndex
+    const int* GetSourceObjectIndexes(int objectIndex, int count) const;
+    //! Gets indices in the source data of the listed objects (stored to sourceIndexes)
+    const int* GetSourceObjectIndexes(const int* objectIndexes, int count, std::vector<int>* sourceIndexes) const;
+
+    //! Returns true if the wrapper only changes objects and features set and order
+    bool IsIndexView() const;
+
+    //! Marks indices or custom values of the wrapper as changed
+    void UpdateRevision() {
+        isSourceUpdated_ = false;
+        InvalidateChildren();
+    }
+
+    //! Composes indices in the source data if the wrapper or the wrapped ones were changed
+    void UpdateSource() const {
+        if (!isSourceUpdated_.load(std::memory_order_acquire)) {
+            ComposeSource();
+        }
+    }
+
+    //! Composes indices of the wrapper with ones of the wrapped index view (once for concurrent readers)
+    void ComposeSource() const;
+
+    //! Registers wrapper built on this one
+    void AddChild(DataSetWrapper* child) const;
+    //! Unregisters wrapper built on this one
+    void RemoveChild(DataSetWrapper* child) const;
+    //! Marks composed indices of the wrappers built on this one as changed
+    void InvalidateChildren();
+
     //! Sets subset (list) of feature indices
     void SetFeatureIndexes(sh_ptr< std::vector<int> > featureIndexes);
 
-    //! Creates matrix of custom features
-    void CreateFeatures();
+    //! Creates custom values of the feature
+    std::vector<double>* CreateFeatureOverlay(int featureIndex);
     //! Creates vector of custom targets
     void CreateTargets();
     //! Creates vector of custom weights
@@ -225,6 +384,14 @@ private:
 
     //! Original data
     const IDataSet* dataSet_;
+    //! Compacted copy of the data (original data after compaction)
+    sh_ptr<IDataSet> compactDataSet_;
+    //! Original data if it's a wrapper
+    const DataSetWrapper* parentWrapper_;
+    //! Wrappers built on this one (their composed indices depend on this one)
+    mutable std::vector<DataSetWrapper*> children_;
+    //! Guards the list of wrappers built on this one
+    mutable std::mutex childrenMutex_;
 
     //! Custom metadata wrapper
     std::auto_ptr<MetaDataWrapper> metaData_;
@@ -232,14 +399,26 @@ private:
     sh_ptr< std::vector<int> > featureIndexes_;
     //! Custom object indices
     sh_ptr< std::vector<int> > objectIndexes_;
-    //! Custom object weights
+    //! Custom object weights (by positions in the wrapper)
     std::auto_ptr< std::vector<double> > weights_;
-    //! Custom object targets
+    //! Custom object targets (by positions in the wrapper)
     std::auto_ptr< std::vector<int> > targets_;
-    //! Custom feature values
-    std::auto_ptr< std::vector< std::vector<double> > > features_;
-    //! Custom confidence matrix
+    //! Custom feature values by features of the original data (NULL for not changed features)
+    std::vector< sh_ptr< std::vector<double> > > featureOverlays_;
+    //! Custom confidence matrix (by positions in the wrapper)
     std::auto_ptr< std::vector< std::vector<double> > > confidences_;
+    //! Cached orders of objects by features (for custom object indices)
+    mutable std::vector<SortedIndexes> sortedIndexes_;
+    //! Data which values are read (original data or the first wrapper with custom values)
+    mutable const IDataSet* source_;
+    //! Object indices in the source data (NULL if they are the same)
+    mutable sh_ptr< std::vector<int> > sourceObjectIndexes_;
+    //! Feature indices in the source data (NULL if they are the same)
+    mutable sh_ptr< std::vector<int> > sourceFeatureIndexes_;
+    //! If the source indices are composed for the current indices of the chain
+    mutable std::atomic<bool> isSourceUpdated_;
+    //! Guards composing of the source indices and the cached orders
+    mutable std::mutex sourceMutex_;
 };
 
 } // namespace mll
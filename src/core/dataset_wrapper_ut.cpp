@@ -1,16 +1,59 @@
+#include <algorithm>
+
 #include <gtest/gtest.h>
 
 #include "dataset.h"
 #include "dataset_wrapper.h"
+#include "thread_pool.h"
 
 using namespace mll;
 
 class DataSetWrapperTest : public testing::Test { };
 
+namespace {
+
+//! Reads a subset of the shared data through own wrappers, like a fold of cross-validation
+class FoldReader {
+public:
+	FoldReader(const IDataSet* dataSet, std::vector<double>* results)
+		: dataSet_(dataSet), results_(results) { }
+
+	void operator() (int first, int last) const {
+		for (int t = first; t < last; t++) {
+			DataSetWrapper fold(dataSet_);
+			std::vector<int> indexes;
+			for (int i = t % 3; i < dataSet_->GetObjectCount(); i += 3) {
+				indexes.push_back(i);
+			}
+			fold.SetObjectIndexes(indexes.begin(), indexes.end());
+			fold.SetWeight(0, 1000.0);
+			DataSetWrapper view(&fold);
+			view.SortObjectsByFeature(t % view.GetFeatureCount());
+			double result = 0;
+			for (int i = 0; i < view.GetObjectCount(); i++) {
+				result = result * 0.5 + view.GetFeature(i, t % view.GetFeatureCount()) +
+					view.GetWeight(i) + view.GetTarget(i);
+			}
+			sh_ptr< const std::vector<int> > sorted = dataSet_->GetSortedObjectIndexes(t % view.GetFeatureCount());
+			for (int i = 0; i < (int)sorted->size(); i++) {
+				result = result * 0.5 + sorted->at(i);
+			}
+			results_->at(t) = result;
+		}
+	}
+
+private:
+	const IDataSet* dataSet_;
+	std::vector<double>* results_;
+};
+
+} // namespace
+
 TEST_F(DataSetWrapperTest, WrappingTest) 
 {	
-	const int OBJECTS = 1000 + rand() % 500;
-	const int FEATURES = 5 + rand() % 10;	
+	Random random(1);
+	const int OBJECTS = 1000 + random.NextInt(500);
+	const int FEATURES = 5 + random.NextInt(10);	
 	
 	// Creating dataset
 	DataSet dataSet;
@@ -20,10 +63,10 @@ TEST_F(DataSetWrapperTest, WrappingTest)
 	ASSERT_TRUE(dataSet.GetFeatureCount() == FEATURES);
 	
 	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
-		dataSet.SetTarget(i, rand() % 2);
-		dataSet.SetWeight(i, (double)rand() / RAND_MAX);
+		dataSet.SetTarget(i, random.NextInt(2));
+		dataSet.SetWeight(i, random.NextDouble());
 		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
-			dataSet.SetFeature(i, j, (double)rand() / RAND_MAX);
+			dataSet.SetFeature(i, j, random.NextDouble());
 		}
 	}
 
@@ -51,3 +94,365 @@ TEST_F(DataSetWrapperTest, WrappingTest)
 	testSetWrapper.ResetObjectIndexes();
 	ASSERT_TRUE(testSetWrapper.GetObjectCount() == indexes.size());
 }
+
+TEST_F(DataSetWrapperTest, BulkAccessTest)
+{
+	Random random(2);
+	const int OBJECTS = 200;
+	const int FEATURES = 3;
+
+	DataSet dataSet;
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, random.NextDouble());
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			dataSet.SetFeature(i, j, random.NextDouble());
+		}
+	}
+
+	std::vector<int> indexes;
+	for (int i = 0; i < OBJECTS; i += 3) {
+		indexes.push_back(i);
+	}
+	DataSetWrapper testSet(&dataSet);
+	testSet.SetObjectIndexes(indexes.begin(), indexes.end());
+	DataSetWrapper testSetWrapper(&testSet);
+	testSetWrapper.SortObjectsByFeature(1);
+
+	const int COUNT = testSetWrapper.GetObjectCount();
+	std::vector<double> features(COUNT);
+	std::vector<int> targets(COUNT);
+	std::vector<double> weights(COUNT);
+	testSetWrapper.GetFeatures(2, 0, COUNT, &features[0]);
+	testSetWrapper.GetTargets(0, COUNT, &targets[0]);
+	testSetWrapper.GetWeights(0, COUNT, &weights[0]);
+	for (int i = 0; i < COUNT; i++) {
+		ASSERT_EQ(testSetWrapper.GetFeature(i, 2), features[i]);
+		ASSERT_EQ(testSetWrapper.GetTarget(i), targets[i]);
+		ASSERT_EQ(testSetWrapper.GetWeight(i), weights[i]);
+	}
+
+	std::vector<int> objectIndexes(2);
+	objectIndexes[0] = COUNT - 1;
+	objectIndexes[1] = 0;
+	testSetWrapper.GatherFeatures(0, &objectIndexes[0], 2, &features[0]);
+	ASSERT_EQ(testSetWrapper.GetFeature(COUNT - 1, 0), features[0]);
+	ASSERT_EQ(testSetWrapper.GetFeature(0, 0), features[1]);
+	ASSERT_THROW(testSetWrapper.GetFeatures(0, 1, COUNT, &features[0]), std::out_of_range);
+}
+
+TEST_F(DataSetWrapperTest, SortedIndexesTest)
+{
+	Random random(3);
+	const int OBJECTS = 300;
+	const int FEATURES = 2;
+
+	DataSet dataSet;
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, 0);
+		dataSet.SetFeature(i, 0, random.NextInt(20));
+		dataSet.SetFeature(i, 1, i % 7 == 0 ? NaN : random.NextDouble());
+	}
+
+	for (int j = 0; j < FEATURES; j++) {
+		sh_ptr< const std::vector<int> > sorted = dataSet.GetSortedObjectIndexes(j);
+		ASSERT_EQ(OBJECTS, (int)sorted->size());
+		ASSERT_TRUE(dataSet.GetSortedObjectIndexes(j).get() == sorted.get());
+		std::vector<bool> listed(OBJECTS);
+		for (int i = 0; i < OBJECTS; i++) {
+			listed[sorted->at(i)] = true;
+			if (i > 0) {
+				double prev = dataSet.GetFeature(sorted->at(i - 1), j);
+				double next = dataSet.GetFeature(sorted->at(i), j);
+				ASSERT_TRUE(IsNaN(next) || prev <= next);
+			}
+		}
+		ASSERT_TRUE(std::find(listed.begin(), listed.end(), false) == listed.end());
+	}
+
+	// Subset with repeated objects
+	std::vector<int> indexes;
+	for (int i = 0; i < OBJECTS; i += 2) {
+		indexes.push_back(OBJECTS - 1 - i);
+		if (i % 10 == 0) {
+			indexes.push_back(i);
+		}
+	}
+	DataSetWrapper testSet(&dataSet);
+	testSet.SetObjectIndexes(indexes.begin(), indexes.end());
+	DataSetWrapper testSetWrapper(&testSet);
+	for (int j = 0; j < FEATURES; j++) {
+		sh_ptr< const std::vector<int> > sorted = testSetWrapper.GetSortedObjectIndexes(j);
+		ASSERT_EQ((int)indexes.size(), (int)sorted->size());
+		ASSERT_TRUE(testSet.GetSortedObjectIndexes(j).get() == sorted.get());
+		std::vector<int> counts(indexes.size());
+		for (int i = 0; i < (int)sorted->size(); i++) {
+			counts[sorted->at(i)]++;
+			if (i > 0) {
+				double prev = testSetWrapper.GetFeature(sorted->at(i - 1), j);
+				double next = testSetWrapper.GetFeature(sorted->at(i), j);
+				ASSERT_TRUE(IsNaN(next) || prev <= next);
+			}
+		}
+		ASSERT_TRUE(std::count(counts.begin(), counts.end(), 1) == (int)counts.size());
+	}
+
+	// Changed data is sorted again
+	dataSet.SetFeature(indexes[0], 0, -1.0);
+	ASSERT_EQ(0, testSet.GetSortedObjectIndexes(0)->at(0));
+	testSet.SwapObjects(0, 1);
+	ASSERT_EQ(1, testSet.GetSortedObjectIndexes(0)->at(0));
+}
+
+TEST_F(DataSetWrapperTest, NestedWrappersTest)
+{
+	const int OBJECTS = 100;
+	const int FEATURES = 4;
+
+	std::vector<std::string> classes;
+	classes.push_back("even");
+	classes.push_back("odd");
+
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, i);
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			dataSet.SetFeature(i, j, i * FEATURES + j);
+		}
+	}
+
+	std::vector<int> indexes;
+	for (int i = OBJECTS - 1; i >= 0; i -= 2) {
+		indexes.push_back(i);
+	}
+	std::vector<int> secondIndexes;
+	for (int i = 5; i < (int)indexes.size(); i++) {
+		secondIndexes.push_back(i);
+	}
+	std::vector<int> featureIndexes;
+	featureIndexes.push_back(3);
+	featureIndexes.push_back(1);
+
+	DataSetWrapper first(&dataSet);
+	first.SetObjectIndexes(indexes.begin(), indexes.end());
+	DataSetWrapper second(&first);
+	second.SetObjectIndexes(secondIndexes.begin(), secondIndexes.end());
+	second.SetFeatureIndexes(featureIndexes.begin(), featureIndexes.end());
+	DataSetWrapper third(&second);
+
+	// third object 0 -> second 0 -> first 5 -> dataset indexes[5]
+	int actual = indexes[5];
+	ASSERT_EQ((int)indexes.size() - 5, third.GetObjectCount());
+	ASSERT_EQ(actual * FEATURES + 3, third.GetFeature(0, 0));
+	ASSERT_EQ(actual * FEATURES + 1, third.GetFeature(0, 1));
+	ASSERT_EQ(actual % 2, third.GetTarget(0));
+	ASSERT_EQ((double)actual, third.GetWeight(0));
+
+	// Changes of inner wrappers are seen by outer ones
+	first.SwapObjects(5, 6);
+	actual = indexes[6];
+	ASSERT_EQ(actual * FEATURES + 3, third.GetFeature(0, 0));
+	second.SetTarget(0, 1 - actual % 2);
+	ASSERT_EQ(1 - actual % 2, third.GetTarget(0));
+	ASSERT_EQ(actual % 2, first.GetTarget(5));
+	second.ResetTargets();
+	ASSERT_EQ(actual % 2, third.GetTarget(0));
+
+	std::vector<double> features(third.GetObjectCount());
+	third.GetFeatures(1, 0, (int)features.size(), &features[0]);
+	for (int i = 0; i < (int)features.size(); i++) {
+		ASSERT_EQ(third.GetFeature(i, 1), features[i]);
+	}
+	third.SortObjectsByWeight();
+	for (int i = 1; i < third.GetObjectCount(); i++) {
+		ASSERT_TRUE(third.GetWeight(i - 1) <= third.GetWeight(i));
+	}
+}
+
+TEST_F(DataSetWrapperTest, OverlaysTest)
+{
+	const int OBJECTS = 50;
+	const int FEATURES = 3;
+
+	std::vector<std::string> classes;
+	classes.push_back("even");
+	classes.push_back("odd");
+
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, i % 2);
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			dataSet.SetFeature(i, j, i * FEATURES + j);
+		}
+	}
+
+	std::vector<int> indexes;
+	for (int i = 0; i < OBJECTS; i += 2) {
+		indexes.push_back(i);
+	}
+	DataSetWrapper wrapper(&dataSet);
+	wrapper.SetObjectIndexes(indexes.begin(), indexes.end());
+	DataSetWrapper outer(&wrapper);
+
+	// Only the changed feature gets custom values
+	wrapper.SetFeature(1, 2, -1.0);
+	wrapper.SetFeature(3, 2, NaN);
+	wrapper.SetTarget(1, 1);
+	ASSERT_EQ(-1.0, wrapper.GetFeature(1, 2));
+	ASSERT_FALSE(wrapper.HasFeature(3, 2));
+	ASSERT_EQ(2 * FEATURES + 1, wrapper.GetFeature(1, 1));
+	ASSERT_EQ(-1.0, outer.GetFeature(1, 2));
+	ASSERT_EQ(1, outer.GetTarget(1));
+	ASSERT_EQ(2 * FEATURES + 2, dataSet.GetFeature(2, 2));
+	ASSERT_EQ(0, dataSet.GetTarget(2));
+
+	std::vector<double> features(wrapper.GetObjectCount());
+	wrapper.GetFeatures(2, 0, (int)features.size(), &features[0]);
+	ASSERT_EQ(-1.0, features[1]);
+	ASSERT_EQ(4 * FEATURES + 2, features[2]);
+
+	// Custom values follow the objects
+	wrapper.SwapObjects(0, 1);
+	ASSERT_EQ(-1.0, wrapper.GetFeature(0, 2));
+	ASSERT_EQ(1, wrapper.GetTarget(0));
+	wrapper.ResetObjectIndexes();
+	ASSERT_EQ(OBJECTS, wrapper.GetObjectCount());
+	ASSERT_EQ(-1.0, wrapper.GetFeature(2, 2));
+	ASSERT_FALSE(wrapper.HasFeature(6, 2));
+	ASSERT_EQ(1, wrapper.GetTarget(2));
+	ASSERT_EQ(1 * FEATURES + 2, wrapper.GetFeature(1, 2));
+	ASSERT_EQ(1, wrapper.GetTarget(1));
+
+	wrapper.Reset();
+	ASSERT_EQ(2 * FEATURES + 2, outer.GetFeature(2, 2));
+	ASSERT_EQ(0, outer.GetTarget(2));
+}
+
+TEST_F(DataSetWrapperTest, CompactTest)
+{
+	const int OBJECTS = 120;
+	const int FEATURES = 4;
+
+	std::vector<std::string> classes;
+	classes.push_back("even");
+	classes.push_back("odd");
+
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, i);
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			dataSet.SetFeature(i, j, i % 5 == j ? NaN : i * FEATURES + j);
+		}
+	}
+
+	std::vector<int> indexes;
+	for (int i = 0; i < OBJECTS; i += 3) {
+		indexes.push_back(OBJECTS - 1 - i);
+	}
+	std::vector<int> featureIndexes;
+	featureIndexes.push_back(2);
+	featureIndexes.push_back(0);
+
+	DataSetWrapper wrapper(&dataSet);
+	wrapper.SetObjectIndexes(indexes.begin(), indexes.end());
+	wrapper.SetFeatureIndexes(featureIndexes.begin(), featureIndexes.end());
+	wrapper.SetWeight(0, 0.5);
+	DataSetWrapper expected(&wrapper);
+	expected.Compact();
+	ASSERT_FALSE(wrapper.CompactForPasses(1));
+	ASSERT_TRUE(wrapper.CompactForPasses(DefaultCompactPassCount));
+	ASSERT_FALSE(wrapper.CompactForPasses(DefaultCompactPassCount));
+
+	ASSERT_EQ((int)indexes.size(), wrapper.GetObjectCount());
+	ASSERT_EQ((int)featureIndexes.size(), wrapper.GetFeatureCount());
+	ASSERT_EQ(0.5, wrapper.GetWeight(0));
+	for (int i = 0; i < wrapper.GetObjectCount(); i++) {
+		ASSERT_EQ(dataSet.GetTarget(indexes[i]), wrapper.GetTarget(i));
+		for (int j = 0; j < wrapper.GetFeatureCount(); j++) {
+			ASSERT_EQ(dataSet.HasFeature(indexes[i], featureIndexes[j]), wrapper.HasFeature(i, j));
+			if (wrapper.HasFeature(i, j)) {
+				ASSERT_EQ(dataSet.GetFeature(indexes[i], featureIndexes[j]), wrapper.GetFeature(i, j));
+				ASSERT_EQ(wrapper.GetFeature(i, j), expected.GetFeature(i, j));
+			}
+		}
+	}
+
+	// The compacted wrapper doesn't depend on the original data
+	dataSet.SetFeature(indexes[0], featureIndexes[0], -1.0);
+	ASSERT_NE(-1.0, wrapper.GetFeature(0, 0));
+	std::vector<int> compactIndexes(1, 0);
+	ASSERT_THROW(wrapper.SetObjectIndexes(indexes.begin(), indexes.begin() + 1), std::out_of_range);
+	wrapper.SetObjectIndexes(compactIndexes.begin(), compactIndexes.end());
+	ASSERT_EQ(1, wrapper.GetObjectCount());
+	ASSERT_EQ(0.5, wrapper.GetWeight(0));
+}
+
+TEST_F(DataSetWrapperTest, ConcurrentReadingTest)
+{
+	Random random(7);
+	const int OBJECTS = 3000;
+	const int FEATURES = 6;
+	const int FOLDS = 64;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetTarget(i, random.NextInt(2));
+		dataSet.SetWeight(i, random.NextDouble());
+		for (int j = 0; j < FEATURES; j++) {
+			dataSet.SetFeature(i, j, random.NextInt(100));
+		}
+	}
+	std::vector<int> indexes;
+	for (int i = OBJECTS - 1; i >= 0; i -= 2) {
+		indexes.push_back(i);
+	}
+
+	// Chains built the same way are read by one thread and concurrently
+	std::vector<double> expected(FOLDS);
+	{
+		DataSetWrapper shared(&dataSet);
+		shared.SetObjectIndexes(indexes.begin(), indexes.end());
+		shared.SetTarget(1, 1 - shared.GetTarget(1));
+		DataSetWrapper sharedView(&shared);
+		sharedView.SortObjectsByWeight();
+		FoldReader(&sharedView, &expected)(0, FOLDS);
+	}
+	ThreadPool pool(4);
+	for (int k = 0; k < 5; k++) {
+		DataSetWrapper shared(&dataSet);
+		shared.SetObjectIndexes(indexes.begin(), indexes.end());
+		shared.SetTarget(1, 1 - shared.GetTarget(1));
+		DataSetWrapper sharedView(&shared);
+		sharedView.SortObjectsByWeight();
+		std::vector<double> results(FOLDS);
+		pool.ParallelFor(0, FOLDS, FoldReader(&sharedView, &results));
+		for (int t = 0; t < FOLDS; t++) {
+			ASSERT_EQ(expected[t], results[t]);
+		}
+	}
+
+	// Changes of a wrapper are not seen by the wrapped one
+	DataSetWrapper shared(&dataSet);
+	shared.SetObjectIndexes(indexes.begin(), indexes.end());
+	DataSetWrapper child(&shared);
+	child.SwapObjects(0, 1);
+	child.SetWeight(0, 1000.0);
+	ASSERT_EQ(dataSet.GetWeight(indexes[0]), shared.GetWeight(0));
+	ASSERT_EQ(dataSet.GetWeight(indexes[1]), shared.GetWeight(1));
+	ASSERT_EQ(dataSet.GetWeight(indexes[0]), child.GetWeight(1));
+}
@@ -20,10 +20,39 @@ namespace {
 
 	const size_t HEADS_NUM=(MAX_SIZE+SVP-1)/SVP;
 
-	void* heads[HEADS_NUM];
+	fixed_alloc_private::depot depots[HEADS_NUM];
+
+	thread_local fixed_alloc_private::thread_cache caches[HEADS_NUM];
+
+	// locks the depot unless the process uses one thread
+	class depot_lock {
+		std::mutex* mutex;
+
+	public:
+		explicit depot_lock(fixed_alloc_private::depot& d)
+			: mutex(fixed_alloc_private::single_threaded ? 0 : &d.mutex)
+		{
+			if (mutex) mutex->lock();
+		}
+
+		~depot_lock() { if (mutex) mutex->unlock(); }
+	};
+
+	void put_batch(fixed_alloc_private::depot& d, void* head, size_t count)
+	{
+		fixed_alloc_private::depot::batch b;
+		b.head=head;
+		b.count=count;
+
+		depot_lock lock(d);
+		if (!d.batches) d.batches=new std::vector<fixed_alloc_private::depot::batch>();
+		d.batches->push_back(b);
+	}
 
 }
 
+bool fixed_alloc_private::single_threaded=false;
+
 void fixed_alloc_private::get_mem(void*& head, size_t type_sz)
 {
 	size_t n =( CHUNK_SIZE > type_sz ) ? CHUNK_SIZE / type_sz : 1;
@@ -39,17 +68,54 @@ void fixed_alloc_private::get_mem(void*& head, size_t type_sz)
 	}
 }
 
+fixed_alloc_private::thread_cache::~thread_cache()
+{
+	if (head) put_batch(*owner, head, count);
+	head=0;
+	count=0;
+}
+
+void fixed_alloc_private::refill(thread_cache& cache, depot& shared, size_t type_sz)
+{
+	cache.owner=&shared;
+	{
+		depot_lock lock(shared);
+		if (shared.batches && !shared.batches->empty()) {
+			cache.head=shared.batches->back().head;
+			cache.count=shared.batches->back().count;
+			shared.batches->pop_back();
+			return;
+		}
+	}
+	get_mem(cache.head, type_sz);
+	cache.count=( CHUNK_SIZE > type_sz ) ? CHUNK_SIZE / type_sz : 1;
+}
+
+void fixed_alloc_private::flush(thread_cache& cache, depot& shared)
+{
+	// the first BATCH_SIZE blocks are returned, the rest stays in the cache
+	void* head=cache.head;
+	void* last=head;
+	for (size_t i=1; i<BATCH_SIZE; i++) last=*(void**)last;
+
+	cache.head=*(void**)last;
+	cache.count-=BATCH_SIZE;
+	*(void**)last=0;
+	put_batch(shared, head, BATCH_SIZE);
+}
+
 void* sized_alloc::alloc(size_t size)
 {
 	size_t index=(size+SVP-1)/SVP;
 	if (index>=HEADS_NUM) return operator new(size);
 
-	void*& head=heads[index];
-	if (!head ) 
-		fixed_alloc_private::get_mem( head, index * SVP );
+	fixed_alloc_private::thread_cache& cache=caches[index];
+	if (!cache.head)
+		fixed_alloc_private::refill(cache, depots[index], index * SVP);
 
-	void* ret=head;
-	head=*(void**)head;
+	void* ret=cache.head;
+	cache.head=*(void**)ret;
+	--cache.count;
 
 	return ret;
 }
@@ -60,8 +126,11 @@ void sized_alloc::free(void* ptr, size_t size)
 	if( index >= HEADS_NUM ){ 
 		operator delete(ptr);
 	} else {
-		void*& head=heads[index];
-		*(void**)ptr=head;
-		head=ptr;
+		fixed_alloc_private::thread_cache& cache=caches[index];
+		cache.owner=&depots[index];
+		*(void**)ptr=cache.head;
+		cache.head=ptr;
+		if (++cache.count>=2*fixed_alloc_private::BATCH_SIZE)
+			fixed_alloc_private::flush(cache, depots[index]);
 	}
 }
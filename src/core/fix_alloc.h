@@ -12,36 +12,91 @@
 #define __FIX_ALLOC_HPP__
 
 #include <stddef.h>
+#include <mutex>
+#include <vector>
 
 namespace fixed_alloc_private {
 
+	// if the process declared that it uses one thread
+	extern bool single_threaded;
+
+	// number of free blocks a thread returns to the depot at once
+	const size_t BATCH_SIZE=64;
+
 	void get_mem(void*& head, size_t type_sz);
 
+	// free blocks of one size shared by all threads, kept in lists of blocks
+	struct depot {
+		struct batch {
+			void* head;
+			size_t count;
+		};
+
+		std::mutex mutex;
+		std::vector<batch>* batches;	// created on the first put, never destroyed
+	};
+
+	// free blocks of one size owned by one thread, returned to the depot on thread exit
+	struct thread_cache {
+		void* head;
+		size_t count;
+		depot* owner;	// depot the blocks are returned to
+
+		~thread_cache();
+	};
+
+	// takes a list of free blocks from the depot (or new memory) to the empty cache
+	void refill(thread_cache& cache, depot& shared, size_t type_sz);
+
+	// returns a batch of free blocks from the cache to the depot
+	void flush(thread_cache& cache, depot& shared);
+
+	// free lists are per-thread caches exchanging batches with the shared depot
 	template <size_t SIZE>
 	class void_alloc {
-		static void* head;
+		static depot shared;
+		static thread_local thread_cache local;
 
 	public:
 		static void* alloc()
 		{
-			if (!head) get_mem(head, SIZE);
+			thread_cache& cache=local;
+			if (!cache.head) refill(cache, shared, SIZE);
 
-			void* ret=head;
-			head=*(void**)head;
+			void* ret=cache.head;
+			cache.head=*(void**)ret;
+			--cache.count;
 
 			return ret;
 		}
 
 		static void free(void* ptr)
 		{
-			*(void**)ptr=head;
-			head=ptr;
+			thread_cache& cache=local;
+			*(void**)ptr=cache.head;
+			cache.head=ptr;
+			if (++cache.count>=2*BATCH_SIZE) flush(cache, shared);
 		}
 	};
 
 	template <size_t SIZE>
-	void* void_alloc<SIZE>::head;
+	depot void_alloc<SIZE>::shared;
+
+	template <size_t SIZE>
+	thread_local thread_cache void_alloc<SIZE>::local={ 0, 0, &void_alloc<SIZE>::shared };
+
+}
+
+// declares that the process uses one thread (must be called before other threads are started):
+// reference counters of shared pointers and the depots of free blocks skip synchronization
+inline void set_single_threaded(bool value)
+{
+	fixed_alloc_private::single_threaded=value;
+}
 
+inline bool is_single_threaded()
+{
+	return fixed_alloc_private::single_threaded;
 }
 
 template <class T>
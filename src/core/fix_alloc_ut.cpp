@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "sh_ptr.h"
+#include "thread_pool.h"
+
+using namespace mll;
+
+class FixAllocTest : public testing::Test {
+protected:
+	virtual void TearDown() {
+		set_single_threaded(false);
+	}
+
+	struct Block {
+		int Values[6];
+	};
+
+	//! Allocates blocks, checks that they don't overlap and frees them in other order
+	class AllocFunction {
+	public:
+		explicit AllocFunction(std::vector<int>* errors) : errors_(errors) { }
+
+		void operator() (int first, int last) const {
+			for (int t = first; t < last; t++) {
+				std::vector<Block*> blocks;
+				for (int i = 0; i < 1000; i++) {
+					Block* block = fixed_alloc<Block>::alloc();
+					std::fill(block->Values, block->Values + 6, t * 1000 + i);
+					blocks.push_back(block);
+				}
+				for (int i = 0; i < (int)blocks.size(); i++) {
+					if (blocks[i]->Values[0] != t * 1000 + i || blocks[i]->Values[5] != t * 1000 + i) {
+						errors_->at(t)++;
+					}
+				}
+				for (int i = (int)blocks.size() - 1; i >= 0; i -= 2) {
+					fixed_alloc<Block>::free(blocks[i]);
+				}
+				for (int i = (int)blocks.size() - 2; i >= 0; i -= 2) {
+					fixed_alloc<Block>::free(blocks[i]);
+				}
+			}
+		}
+
+	private:
+		std::vector<int>* errors_;
+	};
+
+	//! Copies and releases one shared pointer
+	class CopyFunction {
+	public:
+		explicit CopyFunction(const sh_ptr<int>* pointer) : pointer_(pointer) { }
+
+		void operator() (int first, int last) const {
+			for (int t = first; t < last; t++) {
+				std::vector< sh_ptr<int> > copies(100, *pointer_);
+				for (int i = 0; i < 1000; i++) {
+					copies[i % copies.size()] = *pointer_;
+					sh_ptr<int> own(new int(i));
+					copies[(i + 1) % copies.size()] = own;
+				}
+			}
+		}
+
+	private:
+		const sh_ptr<int>* pointer_;
+	};
+};
+
+TEST_F(FixAllocTest, ConcurrentAllocTest)
+{
+	ThreadPool pool(4);
+	std::vector<int> errors(32);
+	pool.ParallelFor(0, (int)errors.size(), AllocFunction(&errors));
+	for (int t = 0; t < (int)errors.size(); t++) {
+		ASSERT_EQ(0, errors[t]);
+	}
+
+	// blocks freed by other threads are reused
+	std::vector<void*> blocks;
+	for (int i = 0; i < 1000; i++) {
+		blocks.push_back(sized_alloc::alloc(40));
+	}
+	std::sort(blocks.begin(), blocks.end());
+	ASSERT_TRUE(std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end());
+	for (int i = 0; i < (int)blocks.size(); i++) {
+		sized_alloc::free(blocks[i], 40);
+	}
+}
+
+TEST_F(FixAllocTest, SharedPointerTest)
+{
+	sh_ptr<int> pointer(new int(7));
+	ThreadPool pool(4);
+	pool.ParallelFor(0, 64, CopyFunction(&pointer));
+	ASSERT_EQ(1u, pointer.refs());
+	ASSERT_EQ(7, *pointer);
+}
+
+TEST_F(FixAllocTest, SingleThreadedTest)
+{
+	set_single_threaded(true);
+	{
+		sh_ptr<int> pointer(new int(7));
+		CopyFunction copy(&pointer);
+		copy(0, 1);
+		ASSERT_EQ(1u, pointer.refs());
+		ASSERT_THROW(ThreadPool(2), std::logic_error);
+		ThreadPool pool(1);
+		pool.ParallelFor(0, 4, copy);
+		ASSERT_EQ(1u, pointer.refs());
+	}
+}
@@ -0,0 +1,107 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mll {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : data_(NULL),
+      size_(0),
+      file_(INVALID_HANDLE_VALUE),
+      mapping_(NULL) {
+}
+
+bool MappedFile::Open(const std::string& fileName) {
+    Close();
+    file_ = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+        Close();
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_ == NULL) {
+        Close();
+        return false;
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == NULL) {
+        Close();
+        return false;
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_ != NULL) {
+        UnmapViewOfFile(data_);
+        data_ = NULL;
+    }
+    if (mapping_ != NULL) {
+        CloseHandle(mapping_);
+        mapping_ = NULL;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+    size_ = 0;
+}
+
+#else
+
+MappedFile::MappedFile()
+    : data_(NULL),
+      size_(0) {
+}
+
+bool MappedFile::Open(const std::string& fileName) {
+    Close();
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file == -1) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+    void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // the mapping keeps the file open
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    data_ = static_cast<const char*>(data);
+    size_ = info.st_size;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (data_ != NULL) {
+        munmap(const_cast<char*>(data_), size_);
+        data_ = NULL;
+    }
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+} // namespace mll
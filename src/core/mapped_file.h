@@ -0,0 +1,53 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace mll {
+
+//! Read-only memory-mapped file
+class MappedFile {
+public:
+    //! Default initialization (no file is mapped)
+    MappedFile();
+
+    //! Unmaps the file
+    ~MappedFile();
+
+    //! Maps the whole file into memory, returns false on failure
+    bool Open(const std::string& fileName);
+
+    //! Unmaps the file
+    void Close();
+
+    //! Returns true if a file is mapped
+    bool IsOpen() const {
+        return data_ != NULL;
+    }
+
+    //! Pointer to the first byte of the file (page-aligned)
+    const char* GetData() const {
+        return data_;
+    }
+
+    //! Size of the file in bytes
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data_;  //!< Mapped memory
+    size_t size_;       //!< Size of the mapped memory
+#ifdef _WIN32
+    void* file_;        //!< File handle
+    void* mapping_;     //!< File mapping handle
+#endif
+};
+
+} // namespace mll
+
+#endif // MAPPED_FILE_H_
@@ -45,6 +45,11 @@ public:
     //! Gets the target feature's metadata
     virtual FeatureInfo GetTargetInfo() const;
 
+    //! Number of classes (nominal values of the target feature)
+    virtual int GetClassCount() const {
+        return static_cast<int>(targetNominalValues_.size());
+    }
+
     //! Sets the target feature's metadata
     void SetTargetInfo(FeatureInfo targetInfo) {
         SetTargetName(targetInfo.Name);
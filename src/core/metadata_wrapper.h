@@ -51,6 +51,11 @@ public:
         return metaData_->GetTargetInfo();
     }
 
+    //! Number of classes (nominal values of the target feature)
+    virtual int GetClassCount() const {
+        return metaData_->GetClassCount();
+    }
+
     //! Gets the value of loss function for predicted and actual class labels
     virtual double GetPenalty(int actualClass, int predictedClass) const {
         return metaData_->GetPenalty(actualClass, predictedClass); // TODO: custom penalties
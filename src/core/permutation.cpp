@@ -0,0 +1,179 @@
+#include "permutation.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "random.h"
+#include "util.h"
+
+using std::vector;
+
+namespace mll {
+
+namespace {
+
+//! Number of bits sorted in one radix pass
+const int RadixBits = 8;
+//! Number of buckets of one radix pass
+const int RadixSize = 1 << RadixBits;
+//! Number of radix passes for 64-bit keys
+const int RadixPassCount = 64 / RadixBits;
+//! Smaller ranges are sorted by comparisons
+const int MinRadixSortSize = 64;
+
+//! Gets unsigned integer which is ordered as the value (missed values are the largest)
+uint64_t GetOrderedBits(double value, bool reverse) {
+    if (value != value) {
+        return ~static_cast<uint64_t>(0);
+    }
+    if (value == 0) {
+        // -0.0 is equal to 0.0
+        value = 0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t signBit = static_cast<uint64_t>(1) << 63;
+    bits = (bits & signBit) != 0 ? ~bits : bits | signBit;
+    return reverse ? ~bits : bits;
+}
+
+//! Compares elements by the keys listed in the same order
+class KeyComparator {
+private:
+    const uint64_t* keys_;
+
+public:
+    explicit KeyComparator(const uint64_t* keys)
+        : keys_(keys) {
+    }
+
+    bool operator() (int position1, int position2) const {
+        return keys_[position1] < keys_[position2];
+    }
+};
+
+} // namespace
+
+Permutation::Permutation(int size /*= 0*/) {
+    InitIndexes(size, &indexes_);
+}
+
+bool Permutation::IsIdentity() const {
+    for (int i = 0; i < GetSize(); ++i) {
+        if (indexes_[i] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Permutation Permutation::Compose(const Permutation& next) const {
+    if (next.GetSize() != GetSize()) {
+        throw std::invalid_argument("Permutations have different sizes");
+    }
+    Permutation result;
+    result.indexes_.resize(GetSize());
+    for (int i = 0; i < GetSize(); ++i) {
+        result.indexes_[i] = indexes_[next.indexes_[i]];
+    }
+    return result;
+}
+
+Permutation Permutation::Inverse() const {
+    Permutation result;
+    result.indexes_.resize(GetSize());
+    for (int i = 0; i < GetSize(); ++i) {
+        result.indexes_[indexes_[i]] = i;
+    }
+    return result;
+}
+
+void Permutation::Shuffle(Random* random) {
+    for (int i = GetSize() - 1; i > 0; --i) {
+        std::swap(indexes_[i], indexes_[random->NextInt(i + 1)]);
+    }
+}
+
+void Permutation::SortByKeys(const double* keys, bool reverse /*= false*/) {
+    int size = GetSize();
+    vector<uint64_t> orderedKeys(size);
+    for (int i = 0; i < size; ++i) {
+        orderedKeys[i] = GetOrderedBits(keys[indexes_[i]], reverse);
+    }
+    if (size < MinRadixSortSize) {
+        vector<int> positions;
+        InitIndexes(size, &positions);
+        std::stable_sort(positions.begin(), positions.end(), KeyComparator(orderedKeys.empty() ? NULL : &orderedKeys[0]));
+        vector<int> indexes(size);
+        for (int i = 0; i < size; ++i) {
+            indexes[i] = indexes_[positions[i]];
+        }
+        indexes_.swap(indexes);
+        return;
+    }
+
+    // histograms of all digits are counted at once, passes with one used bucket are skipped
+    vector<int> counts(RadixPassCount * RadixSize);
+    for (int i = 0; i < size; ++i) {
+        for (int pass = 0; pass < RadixPassCount; ++pass) {
+            ++counts[pass * RadixSize + (orderedKeys[i] >> (pass * RadixBits) & (RadixSize - 1))];
+        }
+    }
+    vector<uint64_t> sortedKeys(size);
+    vector<int> sortedIndexes(size);
+    for (int pass = 0; pass < RadixPassCount; ++pass) {
+        int* passCounts = &counts[pass * RadixSize];
+        int shift = pass * RadixBits;
+        if (passCounts[orderedKeys[0] >> shift & (RadixSize - 1)] == size) {
+            continue;
+        }
+        int offset = 0;
+        for (int digit = 0; digit < RadixSize; ++digit) {
+            int count = passCounts[digit];
+            passCounts[digit] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < size; ++i) {
+            int position = passCounts[orderedKeys[i] >> shift & (RadixSize - 1)]++;
+            sortedKeys[position] = orderedKeys[i];
+            sortedIndexes[position] = indexes_[i];
+        }
+        orderedKeys.swap(sortedKeys);
+        indexes_.swap(sortedIndexes);
+    }
+}
+
+void Permutation::SortByCodes(const int* codes, int codeCount, bool reverse /*= false*/) {
+    int size = GetSize();
+    // missed codes (-1) are counted in the bucket 0
+    vector<int> offsets(codeCount + 2);
+    for (int i = 0; i < size; ++i) {
+        int code = codes[indexes_[i]];
+        if (code < -1 || code >= codeCount) {
+            throw std::out_of_range("Code was out of range");
+        }
+        ++offsets[(reverse ? codeCount - 1 - code : code + 1) + 1];
+    }
+    for (int bucket = 1; bucket < static_cast<int>(offsets.size()); ++bucket) {
+        offsets[bucket] += offsets[bucket - 1];
+    }
+    vector<int> indexes(size);
+    for (int i = 0; i < size; ++i) {
+        int code = codes[indexes_[i]];
+        indexes[offsets[reverse ? codeCount - 1 - code : code + 1]++] = indexes_[i];
+    }
+    indexes_.swap(indexes);
+}
+
+void Permutation::Check() const {
+    vector<bool> listed(indexes_.size());
+    for (vector<int>::const_iterator it = indexes_.begin(); it != indexes_.end(); ++it) {
+        if (*it < 0 || *it >= GetSize() || listed[*it]) {
+            throw std::invalid_argument("Indexes are not a permutation");
+        }
+        listed[*it] = true;
+    }
+}
+
+} // namespace mll
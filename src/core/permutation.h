@@ -0,0 +1,83 @@
+#ifndef PERMUTATION_H_
+#define PERMUTATION_H_
+
+#include <algorithm>
+#include <vector>
+
+namespace mll {
+
+class Random;
+
+//! Permutation of objects
+/*! Element i is the index of the object which is moved to position i.
+    A permutation can be applied to a dataset in bulk (IDataSet::ApplyPermutation)
+    or to a wrapper, which reorders the objects as a view of the constant data.
+*/
+class Permutation {
+public:
+    //! Creates identity permutation of the size
+    explicit Permutation(int size = 0);
+
+    //! Creates permutation from the list of indices (throws if it's not a permutation)
+    template<typename TIter>
+    Permutation(TIter first, TIter last)
+        : indexes_(first, last) {
+        Check();
+    }
+
+    //! Number of elements
+    int GetSize() const {
+        return indexes_.size();
+    }
+
+    //! Gets index of the object which is moved to the position
+    int Get(int position) const {
+        return indexes_.at(position);
+    }
+
+    //! Gets all indices
+    const std::vector<int>& GetIndexes() const {
+        return indexes_;
+    }
+
+    //! Returns true if no objects are moved
+    bool IsIdentity() const;
+
+    //! Gets permutation which is equal to applying this one and then the next one
+    Permutation Compose(const Permutation& next) const;
+
+    //! Gets permutation which moves objects back
+    Permutation Inverse() const;
+
+    //! Orders elements randomly (all orders are equally likely)
+    void Shuffle(Random* random);
+
+    //! Reverses order of elements
+    void Reverse() {
+        std::reverse(indexes_.begin(), indexes_.end());
+    }
+
+    //! Orders elements by the predicate on object indices
+    template<typename TPredicate>
+    void Sort(TPredicate predicate) {
+        std::sort(indexes_.begin(), indexes_.end(), predicate);
+    }
+
+    //! Stably orders elements by the keys of the objects (missed values are the last in both orders)
+    /*! Keys are radix sorted by their order-preserving bit images, no comparisons are made.
+    */
+    void SortByKeys(const double* keys, bool reverse = false);
+
+    //! Stably orders elements by the codes of the objects, which must be in [-1, codeCount) (counting sort)
+    void SortByCodes(const int* codes, int codeCount, bool reverse = false);
+
+private:
+    //! Throws if indices are not a permutation
+    void Check() const;
+
+    std::vector<int> indexes_;  //!< Indices of the objects by positions
+};
+
+} // namespace mll
+
+#endif // PERMUTATION_H_
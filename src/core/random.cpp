@@ -0,0 +1,27 @@
+#include "random.h"
+
+#include <stdexcept>
+
+namespace mll {
+
+Random::Random(uint64_t seed /*= 0*/, uint64_t stream /*= 0*/)
+    : seed_(seed),
+      key_(Hash(Hash(seed) + Hash(stream ^ Increment))),
+      counter_(0) {
+}
+
+int Random::NextInt(int count) {
+    if (count <= 0) {
+        throw std::invalid_argument("Count must be positive");
+    }
+    // values above the largest multiple of count are rejected, so all remainders are equally likely
+    uint64_t range = static_cast<uint64_t>(count);
+    uint64_t limit = ~static_cast<uint64_t>(0) - (~static_cast<uint64_t>(0) % range + 1) % range;
+    uint64_t value;
+    do {
+        value = Next();
+    } while (value > limit);
+    return static_cast<int>(value % range);
+}
+
+} // namespace mll
@@ -0,0 +1,70 @@
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include <stdint.h>
+
+namespace mll {
+
+//! Counter-based random number generator.
+/*! Value number n of a stream is a hash of (seed, stream, n), the generator
+    keeps only the key and the counter. Streams of one seed are independent,
+    so each task or thread can draw its own reproducible stream without
+    sharing any state (see GetStream).
+*/
+class Random {
+public:
+    //! Creates generator of the stream of the seed
+    explicit Random(uint64_t seed = 0, uint64_t stream = 0);
+
+    //! Gets next 64 random bits
+    uint64_t Next() {
+        return Hash(key_ + ++counter_ * Increment);
+    }
+
+    //! Gets uniformly distributed integer in [0, count)
+    int NextInt(int count);
+
+    //! Gets uniformly distributed double in [0, 1)
+    double NextDouble() {
+        return static_cast<double>(Next() >> 11) / static_cast<double>(static_cast<uint64_t>(1) << 53);
+    }
+
+    //! Gets integer in [0, count), can be passed to std algorithms
+    int operator() (int count) {
+        return NextInt(count);
+    }
+
+    //! Gets generator of another stream of the same seed
+    Random GetStream(uint64_t stream) const {
+        return Random(seed_, stream);
+    }
+
+    //! Seed of the generator
+    uint64_t GetSeed() const {
+        return seed_;
+    }
+
+    //! Number of values drawn from the stream
+    uint64_t GetCounter() const {
+        return counter_;
+    }
+
+private:
+    //! Odd constant (golden ratio) which separates hashed counters
+    static const uint64_t Increment = 0x9E3779B97F4A7C15ULL;
+
+    //! Mixes bits of the value (bijection)
+    static uint64_t Hash(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+
+    uint64_t seed_;     //!< Seed of the generator
+    uint64_t key_;      //!< Key of the stream
+    uint64_t counter_;  //!< Number of drawn values
+};
+
+} // namespace mll
+
+#endif // RANDOM_H_
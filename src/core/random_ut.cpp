@@ -0,0 +1,52 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "permutation.h"
+#include "random.h"
+
+using namespace mll;
+
+class RandomTest : public testing::Test { };
+
+TEST_F(RandomTest, StreamsTest)
+{
+	const int VALUES = 10000;
+
+	Random random(42);
+	Random same(42);
+	Random stream = random.GetStream(1);
+	int equalCount = 0;
+	std::vector<int> counts(10);
+	for (int i = 0; i < VALUES; i++) {
+		uint64_t value = random.Next();
+		ASSERT_EQ(value, same.Next());
+		equalCount += value == stream.Next();
+	}
+	for (int i = 0; i < VALUES; i++) {
+		int index = random.NextInt(10);
+		ASSERT_LE(0, index);
+		ASSERT_GT(10, index);
+		counts[index]++;
+		double fraction = random.NextDouble();
+		ASSERT_LE(0.0, fraction);
+		ASSERT_GT(1.0, fraction);
+	}
+	ASSERT_EQ(0, equalCount);
+	ASSERT_EQ(3 * VALUES, static_cast<int>(random.GetCounter()));
+	for (int k = 0; k < 10; k++) {
+		ASSERT_LT(VALUES / 10 - 300, counts[k]);
+		ASSERT_GT(VALUES / 10 + 300, counts[k]);
+	}
+	ASSERT_THROW(random.NextInt(0), std::invalid_argument);
+
+	// the same seed gives the same shuffle
+	Random first(5);
+	Random second(5);
+	Permutation permutation(100);
+	Permutation samePermutation(100);
+	permutation.Shuffle(&first);
+	samePermutation.Shuffle(&second);
+	ASSERT_FALSE(permutation.IsIdentity());
+	ASSERT_TRUE(permutation.GetIndexes() == samePermutation.GetIndexes());
+}
@@ -10,14 +10,37 @@
 
 #ifndef __SH_PTR_HPP__
 #define __SH_PTR_HPP__
+#include <atomic>
 #include "fix_alloc.h"
 
+namespace sh_ptr_private {
+
+	// reference counters are atomic unless the process declared that it uses one thread
+	inline void add_ref(std::atomic<size_t>& refs)
+	{
+		if (is_single_threaded()) refs.store(refs.load(std::memory_order_relaxed)+1, std::memory_order_relaxed);
+		else refs.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// returns true if the last reference was released
+	inline bool release(std::atomic<size_t>& refs)
+	{
+		if (is_single_threaded()) {
+			size_t n=refs.load(std::memory_order_relaxed)-1;
+			refs.store(n, std::memory_order_relaxed);
+			return n==0;
+		}
+		return refs.fetch_sub(1, std::memory_order_acq_rel)==1;
+	}
+
+}
+
 //! Implementation of shared smart pointer
 template <class T>
 class sh_ptr {
 	struct Rep {
 		T* ptr;
-		size_t refs;
+		std::atomic<size_t> refs;	// pointers to one object can be copied by different threads
 
 		Rep(T* ptr_) : ptr(ptr_), refs(1) {}
 
@@ -49,14 +72,14 @@ public:
 	sh_ptr(const sh_ptr& shp)
 	{
 		rep=shp.rep;
-		rep->refs++;
+		sh_ptr_private::add_ref(rep->refs);
 	}
-	~sh_ptr() { if (--rep->refs==0) delete rep; }
+	~sh_ptr() { if (sh_ptr_private::release(rep->refs)) delete rep; }
 
 	sh_ptr& operator=(const sh_ptr& shp)
 	{
-		shp.rep->refs++;
-		if (--rep->refs==0) delete rep;
+		sh_ptr_private::add_ref(shp.rep->refs);
+		if (sh_ptr_private::release(rep->refs)) delete rep;
 		rep=shp.rep;
 
 		return *this;
@@ -84,7 +107,7 @@ template <class T>
 class sh_array {
 	struct Rep {
 		T* ptr;
-		size_t refs;
+		std::atomic<size_t> refs;
 
 		Rep(T* ptr_) : ptr(ptr_), refs(1) {}
 
@@ -116,15 +139,15 @@ public:
 	sh_array(const sh_array& sha)
 	{
 		rep=sha.rep;
-		rep->refs++;
+		sh_ptr_private::add_ref(rep->refs);
 	}
 
-	~sh_array() { if (--rep->refs==0) delete rep; }
+	~sh_array() { if (sh_ptr_private::release(rep->refs)) delete rep; }
 
 	sh_array& operator=(const sh_array& sha)
 	{
-		sha.rep->refs++;
-		if (--rep->refs==0) delete rep;
+		sh_ptr_private::add_ref(sha.rep->refs);
+		if (sh_ptr_private::release(rep->refs)) delete rep;
 		rep=sha.rep;
 
 		return *this;
@@ -0,0 +1,247 @@
+#include "sparse_dataset.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "util.h"
+
+using std::string;
+using std::vector;
+
+namespace mll {
+
+namespace {
+
+typedef std::pair<int, double> SparseEntry;
+
+bool CompareByFeatureIndex(const SparseEntry& entry1, const SparseEntry& entry2) {
+    return entry1.first < entry2.first;
+}
+
+const char* SkipWhiteSpaces(const char* position, const char* end) {
+    while (position < end && isspace(*position)) {
+        ++position;
+    }
+    return position;
+}
+
+const char* SkipToken(const char* position, const char* end) {
+    while (position < end && !isspace(*position)) {
+        ++position;
+    }
+    return position;
+}
+
+} // namespace
+
+double SparseDataSet::GetFeature(int objectIndex, int featureIndex) const {
+    size_t position;
+    return FindFeature(objectIndex, featureIndex, &position) ? features_[position] : 0;
+}
+
+void SparseDataSet::SetFeature(int objectIndex, int featureIndex, double feature) {
+    size_t position;
+    if (FindFeature(objectIndex, featureIndex, &position)) {
+        features_[position] = feature;
+        return;
+    }
+    if (feature == 0) {
+        return;
+    }
+    size_t start = rowStarts_[objectIndex];
+    int length = rowLengths_[objectIndex];
+    if (start + length != featureIndexes_.size()) {
+        // moving the row to the end of the storage, the old place is left unused
+        size_t newStart = featureIndexes_.size();
+        for (int i = 0; i < length; ++i) {
+            int index = featureIndexes_[start + i];
+            double value = features_[start + i];
+            featureIndexes_.push_back(index);
+            features_.push_back(value);
+        }
+        rowStarts_[objectIndex] = start = newStart;
+    }
+    size_t offset = std::lower_bound(
+        featureIndexes_.begin() + start,
+        featureIndexes_.begin() + start + length,
+        featureIndex) - featureIndexes_.begin();
+    featureIndexes_.insert(featureIndexes_.begin() + offset, featureIndex);
+    features_.insert(features_.begin() + offset, feature);
+    ++rowLengths_[objectIndex];
+}
+
+double SparseDataSet::GetConfidence(int objectIndex, int target) const {
+    if (static_cast<int>(confidences_.size()) > objectIndex &&
+        confidences_.at(objectIndex).size() > 0)
+    {
+        return confidences_.at(objectIndex).at(target);
+    } else {
+        if (target == Refuse) {
+            return 0;
+        }
+        int actualTarget = GetTarget(objectIndex);
+        if (target == actualTarget) {
+            return 1.0;
+        } else if (actualTarget == Refuse) {
+            return 1.0 / GetClassCount();
+        } else {
+            return 0;
+        }
+    }
+}
+
+void SparseDataSet::SetConfidence(int objectIndex, int target, double confidence) {
+    if (confidence >= 0) {
+        if (static_cast<int>(confidences_.size()) <= objectIndex) {
+            confidences_.resize(GetObjectCount());
+        }
+        if (confidences_.at(objectIndex).size() == 0) {
+            confidences_.at(objectIndex).resize(GetClassCount());
+        }
+        confidences_.at(objectIndex).at(target) = confidence;
+    }
+}
+
+void SparseDataSet::SwapObjects(int objectIndex1, int objectIndex2) {
+    std::swap(rowStarts_.at(objectIndex1), rowStarts_.at(objectIndex2));
+    std::swap(rowLengths_.at(objectIndex1), rowLengths_.at(objectIndex2));
+    std::swap(targets_.at(objectIndex1), targets_.at(objectIndex2));
+    std::swap(weights_.at(objectIndex1), weights_.at(objectIndex2));
+    if (!confidences_.empty()) {
+        confidences_.at(objectIndex1).swap(confidences_.at(objectIndex2));
+    }
+}
+
+void SparseDataSet::Clear() {
+    metaData_.Clear();
+    rowStarts_.clear();
+    rowLengths_.clear();
+    featureIndexes_.clear();
+    features_.clear();
+    targets_.clear();
+    weights_.clear();
+    confidences_.clear();
+}
+
+int SparseDataSet::AddObject() {
+    rowStarts_.push_back(featureIndexes_.size());
+    rowLengths_.push_back(0);
+    targets_.push_back(0);
+    weights_.push_back(1);
+    if (!confidences_.empty()) {
+        confidences_.resize(GetObjectCount());
+    }
+    return GetObjectCount() - 1;
+}
+
+bool SparseDataSet::Load(const string& fileName) {
+    std::ifstream input(fileName.c_str());
+    if (!input.is_open()) {
+        return false;
+    }
+    if (!LoadSvmLight(input)) {
+        return false;
+    }
+    metaData_.SetName(fileName);
+    return true;
+}
+
+bool SparseDataSet::LoadSvmLight(std::istream& input) {
+    Clear();
+    int featureCount = 0;
+    vector<double> labels;
+    vector<SparseEntry> row;
+    string line;
+    while (getline(input, line)) {
+        const char* position = line.c_str();
+        const char* end = strchr(position, '#');
+        if (end == NULL) {
+            end = position + line.length();
+        }
+        position = SkipWhiteSpaces(position, end);
+        if (position == end) {
+            continue;
+        }
+        char* next;
+        double label = strtod(position, &next);
+        if (next == position || (next < end && !isspace(*next))) {
+            return false;
+        }
+        position = next;
+        row.clear();
+        bool sorted = true;
+        while ((position = SkipWhiteSpaces(position, end)) < end) {
+            if (strncmp(position, "qid:", 4) == 0) {
+                position = SkipToken(position, end);
+                continue;
+            }
+            long index = strtol(position, &next, 10);
+            if (next == position || *next != ':' || index < 1 || index > INT_MAX) {
+                return false;
+            }
+            position = next + 1;
+            double value = strtod(position, &next);
+            if (next == position || (next < end && !isspace(*next))) {
+                return false;
+            }
+            position = next;
+            featureCount = std::max(featureCount, static_cast<int>(index));
+            if (value != 0) {
+                if (!row.empty() && row.back().first >= index - 1) {
+                    sorted = false;
+                }
+                row.push_back(SparseEntry(index - 1, value));
+            }
+        }
+        if (!sorted) {
+            std::stable_sort(row.begin(), row.end(), CompareByFeatureIndex);
+            for (int i = 1; i < static_cast<int>(row.size()); ++i) {
+                if (row[i - 1].first == row[i].first) {
+                    return false;
+                }
+            }
+        }
+        rowStarts_.push_back(featureIndexes_.size());
+        rowLengths_.push_back(row.size());
+        for (vector<SparseEntry>::const_iterator it = row.begin(); it != row.end(); ++it) {
+            featureIndexes_.push_back(it->first);
+            features_.push_back(it->second);
+        }
+        labels.push_back(label);
+    }
+
+    vector<double> classLabels(labels);
+    std::sort(classLabels.begin(), classLabels.end());
+    classLabels.erase(std::unique(classLabels.begin(), classLabels.end()), classLabels.end());
+    vector<string> nominalValues;
+    for (vector<double>::const_iterator it = classLabels.begin(); it != classLabels.end(); ++it) {
+        nominalValues.push_back(ToString(*it));
+    }
+    string targetName = "class";
+    metaData_.SetTargetInfo(FeatureInfo(targetName, Nominal, false, nominalValues));
+    metaData_.SetFeatureCount(featureCount);
+
+    targets_.resize(labels.size());
+    for (int i = 0; i < static_cast<int>(labels.size()); ++i) {
+        targets_[i] = std::lower_bound(classLabels.begin(), classLabels.end(), labels[i]) - classLabels.begin();
+    }
+    weights_.assign(labels.size(), 1.0);
+    return true;
+}
+
+bool SparseDataSet::FindFeature(int objectIndex, int featureIndex, size_t* position) const {
+    if (featureIndex < 0 || featureIndex >= GetFeatureCount()) {
+        throw std::out_of_range("Feature index was out of range");
+    }
+    size_t start = rowStarts_.at(objectIndex);
+    vector<int>::const_iterator first = featureIndexes_.begin() + start;
+    vector<int>::const_iterator last = first + rowLengths_[objectIndex];
+    vector<int>::const_iterator it = std::lower_bound(first, last, featureIndex);
+    *position = it - featureIndexes_.begin();
+    return it != last && *it == featureIndex;
+}
+
+} // namespace mll
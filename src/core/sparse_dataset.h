@@ -0,0 +1,246 @@
+#ifndef SPARSE_DATASET_H_
+#define SPARSE_DATASET_H_
+
+#include <iostream>
+#include <stdexcept>
+
+#include "data.h"
+#include "metadata.h"
+
+namespace mll {
+
+//! Metadata about sparse data. Implements IMetaData.
+/*! All features are numeric, unnamed and can't be missed, so nothing is
+    stored per feature.
+*/
+class SparseMetaData: public IMetaData {
+public:
+    //! Default initialization
+    SparseMetaData()
+        : featureCount_(0) {
+    }
+
+    //! Data name
+    virtual const std::string& GetName() const {
+        return metaData_.GetName();
+    }
+
+    //! Sets data name
+    void SetName(const std::string& name) {
+        metaData_.SetName(name);
+    }
+
+    //! Number of features in data
+    virtual int GetFeatureCount() const {
+        return featureCount_;
+    }
+
+    //! Sets number of features in data
+    void SetFeatureCount(int count) {
+        featureCount_ = count;
+    }
+
+    //! Gets the feature's metadata
+    virtual FeatureInfo GetFeatureInfo(int featureIndex) const {
+        if (featureIndex < 0 || featureIndex >= featureCount_) {
+            throw std::out_of_range("Feature index was out of range");
+        }
+        return FeatureInfo(featureName_, Numeric, false, nominalValues_);
+    }
+
+    //! Gets the target feature's metadata
+    virtual FeatureInfo GetTargetInfo() const {
+        return metaData_.GetTargetInfo();
+    }
+
+    //! Number of classes (nominal values of the target feature)
+    virtual int GetClassCount() const {
+        return metaData_.GetClassCount();
+    }
+
+    //! Sets the target feature's metadata
+    void SetTargetInfo(FeatureInfo targetInfo) {
+        metaData_.SetTargetInfo(targetInfo);
+    }
+
+    //! Gets the value of loss function for predicted and actual class labels
+    virtual double GetPenalty(int actualClass, int predictedClass) const {
+        return metaData_.GetPenalty(actualClass, predictedClass);
+    }
+
+    //! Sets the value of loss function for predicted and actual class labels
+    void SetPenalty(int actualClass, int predictedClass, double penalty) {
+        metaData_.SetPenalty(actualClass, predictedClass, penalty);
+    }
+
+    //! Clears all data from metadata
+    void Clear() {
+        metaData_.Clear();
+        featureCount_ = 0;
+    }
+
+private:
+    MetaData metaData_;                         //!< Name, target info and penalties
+    int featureCount_;                          //!< Number of features
+    std::string featureName_;                   //!< Common (empty) feature name
+    std::vector<std::string> nominalValues_;    //!< Common (empty) nominal values
+};
+
+//! Dataset in compressed-sparse-row format. Implements IDataSet interface.
+/*! Only non-zero feature values are stored, so the memory is proportional
+    to the number of non-zeros. Absent values are zeros.
+*/
+class SparseDataSet : public IDataSet {
+public:
+    //! Iterator over non-zero feature values of one object (ascending by feature index)
+    class RowIterator {
+    public:
+        RowIterator(const int* featureIndexes, const double* features, int count)
+            : featureIndexes_(featureIndexes),
+              features_(features),
+              end_(featureIndexes + count) {
+        }
+
+        //! Returns false if all the values are passed
+        bool IsValid() const {
+            return featureIndexes_ != end_;
+        }
+
+        //! Moves to the next non-zero value
+        void Next() {
+            ++featureIndexes_;
+            ++features_;
+        }
+
+        //! Index of the current feature
+        int GetFeatureIndex() const {
+            return *featureIndexes_;
+        }
+
+        //! Value of the current feature
+        double GetFeature() const {
+            return *features_;
+        }
+
+    private:
+        const int* featureIndexes_;
+        const double* features_;
+        const int* end_;
+    };
+
+    //! Default initialization
+    SparseDataSet() {
+    }
+
+    //! Gets metadata about the dataset
+    virtual const IMetaData& GetMetaData() const {
+        return metaData_;
+    }
+
+    //! Gets metadata about the dataset
+    SparseMetaData& GetMetaData() {
+        return metaData_;
+    }
+
+    //! Get number of objects in the dataset
+    virtual int GetObjectCount() const {
+        return static_cast<int>(rowStarts_.size());
+    }
+
+    //! Returns false if the feature value for the object is missed
+    virtual bool HasFeature(int objectIndex, int featureIndex) const {
+        return !IsNaN(GetFeature(objectIndex, featureIndex));
+    }
+
+    //! Gets the object's value of the feature
+    virtual double GetFeature(int objectIndex, int featureIndex) const;
+
+    //! Sets the object's value of the feature
+    /*! Adding a new non-zero value moves the object's row to the end of the storage.
+    */
+    virtual void SetFeature(int objectIndex, int featureIndex, double feature);
+
+    //! Gets the object's value of the target feature
+    virtual int GetTarget(int objectIndex) const {
+        return targets_.at(objectIndex);
+    }
+
+    //! Sets the object's value of the target feature
+    virtual void SetTarget(int objectIndex, int target) {
+        if (target >= 0 && target < GetClassCount()) {
+            targets_.at(objectIndex) = target;
+        }
+    }
+
+    //! Gets the object's weight
+    virtual double GetWeight(int objectIndex) const {
+        return weights_.at(objectIndex);
+    }
+
+    //! Sets the object's weight
+    virtual void SetWeight(int objectIndex, double weight) {
+        if (weight >= 0) {
+            weights_.at(objectIndex) = weight;
+        }
+    }
+
+    //! Returns true if the dataset has matrix of confidences
+    virtual bool HasConfidences() const {
+        return confidences_.size() > 0;
+    }
+
+    //! Gets the object classification confidence for the target
+    virtual double GetConfidence(int objectIndex, int target) const;
+
+    //! Sets the object classification confidence for the target
+    virtual void SetConfidence(int objectIndex, int target, double confidence);
+
+    //! Swaps two objects
+    virtual void SwapObjects(int objectIndex1, int objectIndex2);
+
+    //! Gets iterator over non-zero feature values of the object
+    RowIterator GetRow(int objectIndex) const {
+        size_t start = rowStarts_.at(objectIndex);
+        int length = rowLengths_[objectIndex];
+        return length > 0
+            ? RowIterator(&featureIndexes_[start], &features_[start], length)
+            : RowIterator(NULL, NULL, 0);
+    }
+
+    //! Number of non-zero feature values of the object
+    int GetNonZeroCount(int objectIndex) const {
+        return rowLengths_.at(objectIndex);
+    }
+
+    //! Clears all data from dataset
+    void Clear();
+
+    //! Adds one object to the end with all features equal to zero
+    int AddObject();
+
+    //! Loads data from SVM-Light (LIBSVM) file
+    bool Load(const std::string& fileName);
+
+    //! Loads data in SVM-Light (LIBSVM) format from stream
+    /*! Class labels are numbers, they are mapped to class indices in
+        ascending order.
+    */
+    bool LoadSvmLight(std::istream& input);
+
+private:
+    //! Finds position of the feature value in the storage, returns false if it is zero
+    bool FindFeature(int objectIndex, int featureIndex, size_t* position) const;
+
+    SparseMetaData metaData_;                           //!< Metadata
+    std::vector<size_t> rowStarts_;                     //!< Objects' first values positions
+    std::vector<int> rowLengths_;                       //!< Objects' non-zero values counts
+    std::vector<int> featureIndexes_;                   //!< Indices of non-zero values
+    std::vector<double> features_;                      //!< Non-zero values
+    std::vector<int> targets_;                          //!< Targets vector
+    std::vector<double> weights_;                       //!< Weights vector
+    std::vector< std::vector<double> > confidences_;    //!< Confidences matrix
+};
+
+} // namespace mll
+
+#endif // SPARSE_DATASET_H_
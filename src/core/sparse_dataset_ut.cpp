@@ -0,0 +1,97 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "dataset.h"
+#include "sparse_dataset.h"
+
+using namespace mll;
+
+class SparseDataSetTest : public testing::Test { };
+
+TEST_F(SparseDataSetTest, LoadSvmLightTest)
+{
+	std::istringstream input(
+		"# comment line\n"
+		"+1 1:0.5 3:2 # trailing comment\n"
+		"-1 qid:4 2:1.5 7:-3\n"
+		"\n"
+		"1 5:1e-3 2:4\n");
+
+	SparseDataSet dataSet;
+	ASSERT_TRUE(dataSet.LoadSvmLight(input));
+	ASSERT_EQ(3, dataSet.GetObjectCount());
+	ASSERT_EQ(7, dataSet.GetFeatureCount());
+	ASSERT_EQ(2, dataSet.GetClassCount());
+
+	ASSERT_EQ(1, dataSet.GetTarget(0));
+	ASSERT_EQ(0, dataSet.GetTarget(1));
+	ASSERT_EQ(1, dataSet.GetTarget(2));
+
+	ASSERT_EQ(0.5, dataSet.GetFeature(0, 0));
+	ASSERT_EQ(0.0, dataSet.GetFeature(0, 1));
+	ASSERT_EQ(2.0, dataSet.GetFeature(0, 2));
+	ASSERT_EQ(-3.0, dataSet.GetFeature(1, 6));
+	ASSERT_TRUE(dataSet.HasFeature(1, 0));
+	ASSERT_THROW(dataSet.GetFeature(0, 7), std::out_of_range);
+
+	// unsorted row
+	SparseDataSet::RowIterator it = dataSet.GetRow(2);
+	ASSERT_TRUE(it.IsValid());
+	ASSERT_EQ(1, it.GetFeatureIndex());
+	ASSERT_EQ(4.0, it.GetFeature());
+	it.Next();
+	ASSERT_EQ(4, it.GetFeatureIndex());
+	it.Next();
+	ASSERT_FALSE(it.IsValid());
+
+	dataSet.SetFeature(0, 1, 9.0);
+	dataSet.SwapObjects(0, 2);
+	ASSERT_EQ(3, dataSet.GetNonZeroCount(2));
+	ASSERT_EQ(9.0, dataSet.GetFeature(2, 1));
+	ASSERT_EQ(2.0, dataSet.GetFeature(2, 2));
+	ASSERT_EQ(4.0, dataSet.GetFeature(0, 1));
+
+	std::istringstream broken("1 3:x\n");
+	ASSERT_FALSE(dataSet.LoadSvmLight(broken));
+}
+
+TEST_F(SparseDataSetTest, DenseLoadTest)
+{
+	SparseDataSet sparseDataSet;
+	std::istringstream input("2 1:1\n3 2:1\n1 3:1\n");
+	ASSERT_TRUE(sparseDataSet.LoadSvmLight(input));
+
+	DataSet dataSet(sparseDataSet);
+	ASSERT_EQ(3, dataSet.GetObjectCount());
+	ASSERT_EQ(3, dataSet.GetClassCount());
+	for (int i = 0; i < dataSet.GetObjectCount(); i++) {
+		ASSERT_EQ(sparseDataSet.GetTarget(i), dataSet.GetTarget(i));
+		for (int j = 0; j < dataSet.GetFeatureCount(); j++) {
+			ASSERT_EQ(sparseDataSet.GetFeature(i, j), dataSet.GetFeature(i, j));
+		}
+	}
+}
+
+TEST_F(SparseDataSetTest, TooSparseDenseLoadTest)
+{
+	const char* FILE_NAME = "sparse_dataset_ut.svm";
+
+	// one large index would need 2*10^9 dense columns
+	{
+		std::ofstream output(FILE_NAME);
+		output << "1 2000000000:1\n2 1:1\n";
+	}
+	DataSet dataSet;
+	ASSERT_FALSE(dataSet.Load(FILE_NAME, SvmLight));
+
+	SparseDataSet sparseDataSet;
+	std::ifstream input(FILE_NAME);
+	ASSERT_TRUE(sparseDataSet.LoadSvmLight(input));
+	ASSERT_EQ(2000000000, sparseDataSet.GetFeatureCount());
+	input.close();
+
+	remove(FILE_NAME);
+}
@@ -2,6 +2,8 @@
 
 #include "dataset_wrapper.h"
 
+using std::vector;
+
 namespace mll {
 
 double GetClassificationErrorSum(const IClassifier& classifier,
@@ -16,11 +18,21 @@ double GetClassificationErrorSum(const IClassifier& classifier,
     classifierCopy->Classify(&testSetWrapper);
     testSetWrapper.ResetObjectIndexes();
 
+    int objectCount = testSet->GetObjectCount();
+    if (objectCount == 0) {
+        return 0;
+    }
+    vector<double> weights(objectCount);
+    vector<int> targets(objectCount);
+    vector<int> predictedTargets(objectCount);
+    testSet->GetWeights(0, objectCount, &weights[0]);
+    testSet->GetTargets(0, objectCount, &targets[0]);
+    testSetWrapper.GetTargets(0, objectCount, &predictedTargets[0]);
+
     const IMetaData& metaData = testSet->GetMetaData();
     double error = 0;
-    for (int i = 0; i < testSet->GetObjectCount(); ++i) {
-        error += testSet->GetWeight(i) *
-                 metaData.GetPenalty(testSet->GetTarget(i), testSetWrapper.GetTarget(i));
+    for (int i = 0; i < objectCount; ++i) {
+        error += weights[i] * metaData.GetPenalty(targets[i], predictedTargets[i]);
     }
     return error;
 }
@@ -0,0 +1,194 @@
+#include "thread_pool.h"
+
+#include <memory>
+#include <stdexcept>
+
+namespace mll {
+
+namespace {
+
+//! Pool of the current worker thread
+thread_local const ThreadPool* currentPool = NULL;
+//! Index of the current worker thread in its pool
+thread_local int currentWorker = -1;
+
+//! Guards the global pool
+std::mutex globalPoolMutex;
+//! Pool shared by the whole process
+std::unique_ptr<ThreadPool> globalPool;
+//! Number of threads of the global pool
+int globalThreadCount = 0;
+
+} // namespace
+
+bool TaskHandle::IsDone() const {
+    std::lock_guard<std::mutex> lock(pool_->mutex_);
+    return state_->PendingCount == 0;
+}
+
+void TaskHandle::Wait() {
+    pool_->Wait(state_);
+}
+
+ThreadPool::ThreadPool(int threadCount)
+    : queuedCount_(0),
+      stopped_(false) {
+    if (threadCount <= 0) {
+        threadCount = GetHardwareThreadCount();
+    }
+    if (threadCount > 1 && is_single_threaded()) {
+        throw std::logic_error("Worker threads cannot be started in single-threaded mode");
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        queues_.push_back(new WorkerQueue());
+    }
+    for (int i = 1; i < threadCount; ++i) {
+        threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i - 1));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    changed_.notify_all();
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i].join();
+    }
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        delete queues_[i];
+    }
+}
+
+TaskHandle ThreadPool::Submit(const std::vector<ITask*>& tasks) {
+    sh_ptr<TaskGroupState> state(new TaskGroupState());
+    state->PendingCount = static_cast<int>(tasks.size());
+    if (tasks.empty()) {
+        return TaskHandle(this, state);
+    }
+    WorkerQueue* queue = queues_[GetCurrentQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue->Mutex);
+        for (size_t i = 0; i < tasks.size(); ++i) {
+            QueuedTask task;
+            task.Task = tasks[i];
+            task.State = state;
+            queue->Tasks.push_back(task);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queuedCount_ += static_cast<int>(tasks.size());
+    }
+    changed_.notify_all();
+    return TaskHandle(this, state);
+}
+
+int ThreadPool::GetHardwareThreadCount() {
+    int threadCount = static_cast<int>(std::thread::hardware_concurrency());
+    return threadCount > 0 ? threadCount : 1;
+}
+
+ThreadPool& ThreadPool::GetGlobal() {
+    std::lock_guard<std::mutex> lock(globalPoolMutex);
+    if (globalPool.get() == NULL) {
+        globalPool.reset(new ThreadPool(globalThreadCount));
+    }
+    return *globalPool;
+}
+
+void ThreadPool::SetGlobalThreadCount(int threadCount) {
+    std::lock_guard<std::mutex> lock(globalPoolMutex);
+    globalThreadCount = threadCount;
+    globalPool.reset();
+}
+
+int ThreadPool::GetCurrentQueueIndex() const {
+    return currentPool == this ? currentWorker : static_cast<int>(queues_.size()) - 1;
+}
+
+void ThreadPool::WorkerLoop(int workerIndex) {
+    currentPool = this;
+    currentWorker = workerIndex;
+    while (true) {
+        QueuedTask task;
+        if (TakeTask(workerIndex, &task)) {
+            RunTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopped_ && queuedCount_ <= 0) {
+            changed_.wait(lock);
+        }
+        if (stopped_) {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TakeTask(int workerIndex, QueuedTask* task) {
+    int queueCount = static_cast<int>(queues_.size());
+    // the own deque is used as a stack, others are robbed from the opposite end
+    for (int i = 0; i < queueCount; ++i) {
+        WorkerQueue* queue = queues_[(workerIndex + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue->Mutex);
+        if (!queue->Tasks.empty()) {
+            if (i == 0) {
+                *task = queue->Tasks.back();
+                queue->Tasks.pop_back();
+            } else {
+                *task = queue->Tasks.front();
+                queue->Tasks.pop_front();
+            }
+            --queuedCount_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(const QueuedTask& task) {
+    std::exception_ptr exception;
+    try {
+        task.Task->Run();
+    } catch (...) {
+        exception = std::current_exception();
+    }
+    bool isGroupDone;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (exception && !task.State->Exception) {
+            task.State->Exception = exception;
+        }
+        isGroupDone = --task.State->PendingCount == 0;
+    }
+    if (isGroupDone) {
+        changed_.notify_all();
+    }
+}
+
+void ThreadPool::Wait(const sh_ptr<TaskGroupState>& state) {
+    int queueIndex = GetCurrentQueueIndex();
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (state->PendingCount > 0 && queuedCount_ <= 0) {
+                changed_.wait(lock);
+            }
+            if (state->PendingCount == 0) {
+                break;
+            }
+        }
+        QueuedTask task;
+        if (TakeTask(queueIndex, &task)) {
+            RunTask(task);
+        }
+    }
+    std::exception_ptr exception = state->Exception;
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+} // namespace mll
@@ -0,0 +1,234 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "sh_ptr.h"
+
+namespace mll {
+
+//! Mutex which can be a member of copyable classes (copies get their own mutex)
+class CopyableMutex : public std::mutex {
+public:
+    CopyableMutex() {
+    }
+
+    CopyableMutex(const CopyableMutex&)
+        : std::mutex() {
+    }
+
+    CopyableMutex& operator=(const CopyableMutex&) {
+        return *this;
+    }
+};
+
+//! Task executed by thread pool
+class ITask {
+public:
+    virtual ~ITask() {
+    }
+
+    //! Does the work
+    virtual void Run() = 0;
+};
+
+class ThreadPool;
+
+//! Completion state of submitted tasks (internal)
+struct TaskGroupState {
+    TaskGroupState()
+        : PendingCount(0) {
+    }
+
+    int PendingCount;               //!< Number of tasks not completed yet (guarded by the pool mutex)
+    std::exception_ptr Exception;   //!< First exception thrown by the tasks
+};
+
+//! Handle of tasks submitted to a pool, like a future of their completion
+class TaskHandle {
+public:
+    //! Returns true if all the tasks are completed
+    bool IsDone() const;
+
+    /*! Waits for the tasks to complete, the calling thread runs queued tasks
+        meanwhile (so tasks can wait for nested tasks). Rethrows the first
+        exception thrown by the tasks.
+    */
+    void Wait();
+
+private:
+    friend class ThreadPool;
+
+    TaskHandle(ThreadPool* pool, sh_ptr<TaskGroupState> state)
+        : pool_(pool),
+          state_(state) {
+    }
+
+    ThreadPool* pool_;                  //!< Pool running the tasks
+    sh_ptr<TaskGroupState> state_;      //!< Shared completion state
+};
+
+//! Work-stealing pool of worker threads.
+/*! Each worker has its own deque of tasks: it runs its own tasks in LIFO order
+    and steals the oldest tasks of other workers when it has none. Tasks
+    submitted by other threads are queued in a shared deque. Threads waiting
+    for tasks run queued tasks too, so the pool never needs more threads than
+    cores and nested parallel loops don't deadlock.
+*/
+class ThreadPool {
+public:
+    //! Creates pool of threadCount threads including the calling one (0 for hardware concurrency)
+    /*! Throws if worker threads are needed while single-threaded mode is
+        declared (see set_single_threaded).
+    */
+    explicit ThreadPool(int threadCount = 0);
+
+    //! Stops and joins worker threads
+    ~ThreadPool();
+
+    //! Number of threads which run the tasks (including the calling one)
+    int GetThreadCount() const {
+        return static_cast<int>(threads_.size()) + 1;
+    }
+
+    //! Queues the task, which must live until it's completed
+    TaskHandle Submit(ITask* task) {
+        return Submit(std::vector<ITask*>(1, task));
+    }
+
+    //! Queues the tasks, which must live until they are completed
+    TaskHandle Submit(const std::vector<ITask*>& tasks);
+
+    /*! Runs all the tasks and waits for them to complete. The calling thread
+        runs tasks too. Rethrows the first exception thrown by the tasks.
+    */
+    void Run(const std::vector<ITask*>& tasks) {
+        Submit(tasks).Wait();
+    }
+
+    /*! Calls function(first, last) for subranges of [begin, end) of grainSize
+        elements (the last one can be shorter) and waits for all the calls
+    */
+    template<typename TFunction>
+    void ParallelFor(int begin, int end, const TFunction& function, int grainSize = 1);
+
+    //! Gets number of hardware threads (at least 1)
+    static int GetHardwareThreadCount();
+
+    //! Gets the pool shared by the whole process (created on the first call)
+    static ThreadPool& GetGlobal();
+
+    /*! Sets number of threads of the global pool (0 for hardware concurrency),
+        must be called when the global pool is not used
+    */
+    static void SetGlobalThreadCount(int threadCount);
+
+private:
+    friend class TaskHandle;
+
+    //! Task with the state of its group
+    struct QueuedTask {
+        ITask* Task;
+        sh_ptr<TaskGroupState> State;
+    };
+
+    //! Deque of tasks of one worker
+    struct WorkerQueue {
+        std::mutex Mutex;                   //!< Guards the tasks
+        std::deque<QueuedTask> Tasks;       //!< Queued tasks
+    };
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    //! Main loop of worker threads
+    void WorkerLoop(int workerIndex);
+    //! Takes a task from the own deque or steals one, returns false if there are no tasks
+    bool TakeTask(int workerIndex, QueuedTask* task);
+    //! Runs the task and marks it completed, must be called with mutex unlocked
+    void RunTask(const QueuedTask& task);
+    //! Waits for the tasks of the state running queued tasks meanwhile
+    void Wait(const sh_ptr<TaskGroupState>& state);
+    //! Index of the deque of the calling thread (the shared deque for other threads)
+    int GetCurrentQueueIndex() const;
+
+    std::vector<std::thread> threads_;          //!< Worker threads
+    std::vector<WorkerQueue*> queues_;          //!< Deques of workers and the shared one (the last)
+    std::atomic<int> queuedCount_;              //!< Number of queued tasks (can be less for a moment)
+    std::mutex mutex_;                          //!< Guards sleeping, completion and stopping
+    std::condition_variable changed_;           //!< Signaled when tasks are added, completed or pool is stopped
+    bool stopped_;                              //!< If worker threads must exit
+};
+
+namespace thread_pool_private {
+
+//! Calls the function for one subrange
+template<typename TFunction>
+class RangeTask : public ITask {
+public:
+    RangeTask(const TFunction* function, int first, int last)
+        : function_(function),
+          first_(first),
+          last_(last) {
+    }
+
+    virtual void Run() {
+        (*function_)(first_, last_);
+    }
+
+private:
+    const TFunction* function_;
+    int first_;
+    int last_;
+};
+
+} // namespace thread_pool_private
+
+template<typename TFunction>
+void ThreadPool::ParallelFor(int begin, int end, const TFunction& function, int grainSize /*= 1*/) {
+    grainSize = std::max(grainSize, 1);
+    if (end - begin <= grainSize || GetThreadCount() == 1) {
+        if (begin < end) {
+            function(begin, end);
+        }
+        return;
+    }
+    std::vector< thread_pool_private::RangeTask<TFunction> > rangeTasks;
+    for (int first = begin; first < end; first += std::min(grainSize, end - first)) {
+        rangeTasks.push_back(thread_pool_private::RangeTask<TFunction>(
+            &function, first, first + std::min(grainSize, end - first)));
+    }
+    std::vector<ITask*> tasks;
+    for (size_t i = 0; i < rangeTasks.size(); ++i) {
+        tasks.push_back(&rangeTasks[i]);
+    }
+    Run(tasks);
+}
+
+/*! Calls function(first, last) for subranges of [begin, end) on at most
+    threadCount threads of the global pool (0 for all its threads, 1 to call
+    it once on the calling thread) and waits for all the calls
+*/
+template<typename TFunction>
+void ParallelForThreads(int begin, int end, const TFunction& function, int threadCount) {
+    if (threadCount == 1) {
+        if (begin < end) {
+            function(begin, end);
+        }
+        return;
+    }
+    // the range is split into threadCount subranges, so no more threads run them
+    int grainSize = threadCount > 0 ? (end - begin + threadCount - 1) / threadCount : 1;
+    ThreadPool::GetGlobal().ParallelFor(begin, end, function, grainSize);
+}
+
+} // namespace mll
+
+#endif // THREAD_POOL_H_
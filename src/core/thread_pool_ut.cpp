@@ -0,0 +1,108 @@
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "thread_pool.h"
+
+using namespace mll;
+
+class ThreadPoolTest : public testing::Test {
+protected:
+	//! Adds squares of the indices to the values
+	class SquareFunction {
+	public:
+		explicit SquareFunction(std::vector<long long>* values)
+			: values_(values) {
+		}
+
+		void operator() (int first, int last) const {
+			for (int i = first; i < last; i++) {
+				(*values_)[i] += static_cast<long long>(i) * i;
+			}
+		}
+
+	private:
+		std::vector<long long>* values_;
+	};
+
+	//! Runs nested parallel loop for each index
+	class NestedFunction {
+	public:
+		NestedFunction(ThreadPool* pool, std::vector< std::vector<long long> >* values)
+			: pool_(pool),
+			  values_(values) {
+		}
+
+		void operator() (int first, int last) const {
+			for (int i = first; i < last; i++) {
+				std::vector<long long>& values = (*values_)[i];
+				pool_->ParallelFor(0, static_cast<int>(values.size()), SquareFunction(&values), 7);
+			}
+		}
+
+	private:
+		ThreadPool* pool_;
+		std::vector< std::vector<long long> >* values_;
+	};
+
+	//! Throws for the index 5
+	class ThrowingTask : public ITask {
+	public:
+		explicit ThrowingTask(int index)
+			: index_(index) {
+		}
+
+		virtual void Run() {
+			if (index_ == 5) {
+				throw std::runtime_error("task failed");
+			}
+		}
+
+	private:
+		int index_;
+	};
+};
+
+TEST_F(ThreadPoolTest, ParallelForTest)
+{
+	ThreadPool pool(4);
+	ASSERT_EQ(4, pool.GetThreadCount());
+
+	std::vector<long long> values(10000);
+	pool.ParallelFor(0, static_cast<int>(values.size()), SquareFunction(&values), 100);
+	for (int i = 0; i < static_cast<int>(values.size()); i++) {
+		ASSERT_EQ(static_cast<long long>(i) * i, values[i]);
+	}
+
+	// tasks waiting for nested tasks run queued tasks, so there is no deadlock
+	std::vector< std::vector<long long> > nested(50, std::vector<long long>(100));
+	pool.ParallelFor(0, static_cast<int>(nested.size()), NestedFunction(&pool, &nested));
+	for (int i = 0; i < static_cast<int>(nested.size()); i++) {
+		ASSERT_EQ(99 * 99, nested[i][99]);
+	}
+}
+
+TEST_F(ThreadPoolTest, TaskHandleTest)
+{
+	ThreadPool pool(3);
+	std::vector<ThrowingTask> tasks;
+	for (int i = 0; i < 10; i++) {
+		tasks.push_back(ThrowingTask(i));
+	}
+	std::vector<ITask*> taskPointers;
+	for (int i = 0; i < 10; i++) {
+		taskPointers.push_back(&tasks[i]);
+	}
+	TaskHandle failed = pool.Submit(taskPointers);
+	TaskHandle succeeded = pool.Submit(&tasks[0]);
+	succeeded.Wait();
+	ASSERT_TRUE(succeeded.IsDone());
+	ASSERT_THROW(failed.Wait(), std::runtime_error);
+	ASSERT_TRUE(failed.IsDone());
+
+	ThreadPool::SetGlobalThreadCount(2);
+	ASSERT_EQ(2, ThreadPool::GetGlobal().GetThreadCount());
+	ThreadPool::SetGlobalThreadCount(0);
+	ASSERT_EQ(ThreadPool::GetHardwareThreadCount(), ThreadPool::GetGlobal().GetThreadCount());
+}
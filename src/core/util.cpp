@@ -1,9 +1,114 @@
 #include "util.h"
 
+#include <cstdlib>
+#include <stdint.h>
+
 using std::string;
 
 namespace mll {
 
+namespace {
+
+//! Powers of 10 which are exactly representable by double
+const double ExactPowersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const int MaxExactPowerOf10 = 22;
+const int MaxMantissaDigits = 19;
+const uint64_t MaxExactMantissa = static_cast<uint64_t>(1) << 53;
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+//! Slow path of ParseDouble: correctly rounded conversion by strtod
+bool ParseDoubleSlow(const char* begin, const char* end, double* value) {
+    string buffer(begin, end);
+    char* last;
+    *value = strtod(buffer.c_str(), &last);
+    return last == buffer.c_str() + buffer.length();
+}
+
+} // namespace
+
+bool ParseDouble(const char* begin, const char* end, double* value) {
+    const char* position = begin;
+    bool negative = false;
+    if (position < end && (*position == '-' || *position == '+')) {
+        negative = *position == '-';
+        ++position;
+    }
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool truncated = false;
+    const char* digitsBegin = position;
+    for (; position < end && IsDigit(*position); ++position) {
+        if (digits < MaxMantissaDigits) {
+            mantissa = mantissa * 10 + (*position - '0');
+            digits += mantissa != 0;
+        } else {
+            truncated = true;
+            ++exponent;
+        }
+    }
+    bool hasDigits = position != digitsBegin;
+    if (position < end && *position == '.') {
+        ++position;
+        digitsBegin = position;
+        for (; position < end && IsDigit(*position); ++position) {
+            if (digits < MaxMantissaDigits) {
+                mantissa = mantissa * 10 + (*position - '0');
+                digits += mantissa != 0;
+                --exponent;
+            } else {
+                truncated = true;
+            }
+        }
+        hasDigits = hasDigits || position != digitsBegin;
+    }
+    if (!hasDigits) {
+        return false;
+    }
+    if (position < end && (*position == 'e' || *position == 'E')) {
+        ++position;
+        bool negativeExponent = false;
+        if (position < end && (*position == '-' || *position == '+')) {
+            negativeExponent = *position == '-';
+            ++position;
+        }
+        if (position == end || !IsDigit(*position)) {
+            return false;
+        }
+        int explicitExponent = 0;
+        for (; position < end && IsDigit(*position); ++position) {
+            if (explicitExponent < 100000) {
+                explicitExponent = explicitExponent * 10 + (*position - '0');
+            }
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (position != end) {
+        return false;
+    }
+    if (mantissa == 0 && !truncated) {
+        *value = negative ? -0.0 : 0.0;
+        return true;
+    }
+    if (truncated || mantissa > MaxExactMantissa ||
+        exponent < -MaxExactPowerOf10 || exponent > MaxExactPowerOf10)
+    {
+        return ParseDoubleSlow(begin, end, value);
+    }
+    // both mantissa and power of 10 are exact, so the only rounding is correct
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / ExactPowersOf10[-exponent] : result * ExactPowersOf10[exponent];
+    *value = negative ? -result : result;
+    return true;
+}
+
 std::ostream& NullStream() {
     static std::ostream nullStream(0);
     return nullStream;
@@ -52,6 +52,11 @@ std::string FromString(const std::string& input);
 template<>
 bool FromString(const std::string& input);
 
+//! Converts characters [begin, end) to double, returns false if they are not a number.
+/*! Doesn't depend on the locale and doesn't allocate memory for usual numbers.
+*/
+bool ParseDouble(const char* begin, const char* end, double* value);
+
 //! Null stream
 std::ostream& NullStream();
 
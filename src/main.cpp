@@ -15,6 +15,7 @@
 #include "dataset_wrapper.h"
 #include "factories.h"
 #include "tester.h"
+#include "thread_pool.h"
 #include "logger.h"
 
 using std::cout;
@@ -75,7 +76,8 @@ sh_ptr<ITester> CreateTester(const string& testerName) {
 
 sh_ptr<DataSet> LoadDataSet(const string& fileName) {
     sh_ptr<DataSet> dataSet(new DataSet());
-    if (!dataSet->Load(fileName)) {
+    // parsed on the global pool
+    if (!dataSet->Load(fileName, UnknownFormat, 0)) {
 		LOGF("Can't load dataset %s", LOGSTR(fileName));
     }
     LOGI("DataSet '%s' is loaded:", LOGSTR(dataSet->GetName()));
@@ -168,6 +170,7 @@ int main(int argc, char** argv) {
     try {
 		typedef TCLAP::ValueArg<string> StringArg;
 		typedef TCLAP::UnlabeledValueArg<string> UnlabeledStringArg;
+		typedef TCLAP::ValueArg<int> IntArg;
 
         TCLAP::CmdLine cmd("Command description message", ' ', "0.1");
 
@@ -178,6 +181,10 @@ int main(int argc, char** argv) {
 			"c", "classifier", "Name of classifier", false, "", "string", cmd);
 		StringArg fullDataArg(
 			"", "data", "File with full data", false, "", "string", cmd);
+		StringArg outputArg(
+			"o", "output", "File to write converted data (.mllb)", false, "", "string", cmd);
+		IntArg threadsArg(
+			"j", "threads", "Number of worker threads (0 for all cores)", false, 1, "int", cmd);
 		//StringArg testDataArg(
 		//	"", "trainData", "File with train data", false, "", "string", cmd);
 		//StringArg trainDataArg(
@@ -215,6 +222,11 @@ int main(int argc, char** argv) {
 
 		// Parsing command line...
 		cmd.parse(argc, argv);
+		ThreadPool::SetGlobalThreadCount(threadsArg.getValue());
+		if (threadsArg.getValue() == 1) {
+			// no threads are started, so reference counting can skip atomic operations
+			set_single_threaded(true);
+		}
 
 		{	// Logging command line args...
 			std::list<TCLAP::Arg*>& argList = cmd.getArgList();
@@ -282,6 +294,16 @@ int main(int argc, char** argv) {
 				WriteVector(testTargetOutputArg.getValue(), targets);
 			}	
 		}
+		else if (commandTypeArg.getValue() == "convert") {
+
+			LOGI("Conversion mode...");
+
+			sh_ptr<DataSet> dataSet = LoadDataSet(fullDataArg.getValue());
+			if (!dataSet->SaveBinary(outputArg.getValue())) {
+				LOGF("Can't write dataset to '%s'", LOGSTR(outputArg.getValue()));
+			}
+			LOGI("DataSet is written to '%s'", LOGSTR(outputArg.getValue()));
+		}
 		else {
 			ListClassifiers();
             ListTesters();
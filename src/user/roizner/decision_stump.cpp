@@ -3,6 +3,8 @@
 #include <limits>
 #include <vector>
 
+#include "thread_pool.h"
+
 #define ALGSYNONIM ""
 #define PASSWORD ""
 
@@ -21,17 +23,33 @@ REGISTER_CLASSIFIER(mll::roizner::DecisionStump,
 namespace mll {
 namespace roizner {
 
-//! Choose the best class label for the weight sums on the one side of a threshold.
+//! Gets the penalties of all class labels as a flat matrix: penalties[actual * classCount + predicted]
+void GetPenaltyMatrix(const IMetaData& metaData, vector<double>* penalties) {
+    int classCount = metaData.GetClassCount();
+    penalties->resize(classCount * classCount);
+    for (int actual = 0; actual < classCount; ++actual) {
+        for (int predicted = 0; predicted < classCount; ++predicted) {
+            penalties->at(actual * classCount + predicted) = metaData.GetPenalty(actual, predicted);
+        }
+    }
+}
+
+//! Adds penalties of predicting every label for the object of the class to the costs
+inline void AddObjectCosts(const vector<double>& penalties, int classCount,
+                           int target, double weight, vector<double>* costs) {
+    const double* penaltyRow = &penalties[target * classCount];
+    for (int label = 0; label < classCount; ++label) {
+        (*costs)[label] += weight * penaltyRow[label];
+    }
+}
+
+//! Choose the best class label by the costs of predicting every label on the one side of a threshold
+//! (plus the costs of missed values if they are sent to the side).
 //! Returns the overall penalty for the selected class label
-double SelectClassLabel(const vector<double>& classWeightSums,
-                        const IMetaData& metaData,
-                        int* classLabel) {
+double SelectClassLabel(const vector<double>& costs, const vector<double>* missedCosts, int* classLabel) {
     double minPenalty = std::numeric_limits<double>::max();
-    for (int label = 0; label < metaData.GetClassCount(); ++label) {
-        double penalty = 0;
-        for (int label1 = 0; label1 < metaData.GetClassCount(); ++label1) {
-            penalty += classWeightSums[label1] * metaData.GetPenalty(label1, label);
-        }
+    for (int label = 0; label < static_cast<int>(costs.size()); ++label) {
+        double penalty = missedCosts != NULL ? costs[label] + (*missedCosts)[label] : costs[label];
         if (penalty < minPenalty) {
             minPenalty = penalty;
             *classLabel = label;
@@ -40,44 +58,259 @@ double SelectClassLabel(const vector<double>& classWeightSums,
     return minPenalty;
 }
 
-void DecisionStump::Learn(IDataSet* data) {
-    double minPenalty = std::numeric_limits<double>::max();
-    // Iterating by the feature
-    for (int featureIndex = 0; featureIndex < data->GetFeatureCount(); ++featureIndex) {
-        vector<double> belowThresholdWeightSums(data->GetClassCount());
-        vector<double> aboveThresholdWeightSums(data->GetClassCount());
-        // Initializing weight sums
-        for (int objectIndex = 0; objectIndex < data->GetObjectCount(); ++objectIndex) {
-            aboveThresholdWeightSums[data->GetTarget(objectIndex)] += data->GetWeight(objectIndex);
+//! Best threshold of one feature
+struct Split {
+    Split()
+        : Penalty(std::numeric_limits<double>::max()),
+          BelowThresholdClass(0),
+          AboveThresholdClass(0),
+          Threshold(0),
+          MissedBelowThreshold(false) {
+    }
+
+    double Penalty;             //!< Overall penalty of the split
+    int BelowThresholdClass;    //!< Class label for object below threshold
+    int AboveThresholdClass;    //!< Class label for object above threshold
+    double Threshold;           //!< The feature value threshold
+    bool MissedBelowThreshold;  //!< If objects with missed values are sent below threshold
+};
+
+//! Updates the split if the threshold is better, objects with missed values are sent to the better side
+void TryThreshold(const vector<double>& belowThresholdCosts, const vector<double>& aboveThresholdCosts,
+                  const vector<double>& missedCosts, bool hasMissed, double threshold, Split* split) {
+    int belowThresholdClass, aboveThresholdClass;
+    double penalty =
+        SelectClassLabel(belowThresholdCosts, NULL, &belowThresholdClass) +
+        SelectClassLabel(aboveThresholdCosts, hasMissed ? &missedCosts : NULL, &aboveThresholdClass);
+    bool missedBelowThreshold = false;
+    if (hasMissed) {
+        // missed values go above the threshold unless the other side is strictly better
+        int missedBelowClass, missedAboveClass;
+        double missedBelowPenalty =
+            SelectClassLabel(belowThresholdCosts, &missedCosts, &missedBelowClass) +
+            SelectClassLabel(aboveThresholdCosts, NULL, &missedAboveClass);
+        if (missedBelowPenalty < penalty) {
+            penalty = missedBelowPenalty;
+            belowThresholdClass = missedBelowClass;
+            aboveThresholdClass = missedAboveClass;
+            missedBelowThreshold = true;
         }
-        // Sorting by the feature
-        data->SortObjectsByFeature(featureIndex);
-        // Choosing best threshold
-        for (int objectIndex = 0; objectIndex < data->GetObjectCount(); ++objectIndex) {
-            belowThresholdWeightSums[data->GetTarget(objectIndex)] += data->GetWeight(objectIndex);
-            aboveThresholdWeightSums[data->GetTarget(objectIndex)] -= data->GetWeight(objectIndex);
-            int belowThresholdClass, aboveThresholdClass;
-            double penalty =
-                SelectClassLabel(belowThresholdWeightSums, data->GetMetaData(), &belowThresholdClass) +
-                SelectClassLabel(aboveThresholdWeightSums, data->GetMetaData(), &aboveThresholdClass);
-            if (penalty < minPenalty) {
-                minPenalty = penalty;
-                separatingFeatureIndex_ = featureIndex;
-                belowThresholdClass_ = belowThresholdClass;
-                aboveThresholdClass_ = aboveThresholdClass;
-                double feature = data->GetFeature(objectIndex, featureIndex);
-                threshold_ = 
-                    objectIndex + 1 < data->GetObjectCount()
-                        ? (feature + data->GetFeature(objectIndex + 1, featureIndex)) / 2
-                        : feature + 1.0;
+    }
+    if (penalty < split->Penalty) {
+        split->Penalty = penalty;
+        split->BelowThresholdClass = belowThresholdClass;
+        split->AboveThresholdClass = aboveThresholdClass;
+        split->Threshold = threshold;
+        split->MissedBelowThreshold = missedBelowThreshold;
+    }
+}
+
+//! Searches the threshold of the feature scanning the objects sorted by it
+void FindSortedSplit(const IDataSet& data, int featureIndex, const vector<double>& penalties, Split* split) {
+    int objectCount = data.GetObjectCount();
+    int classCount = data.GetClassCount();
+    vector<double> features(objectCount);
+    vector<int> targets(objectCount);
+    vector<double> weights(objectCount);
+    // Objects ordered by the feature (cached by the dataset), missed values are the last ones
+    sh_ptr< const vector<int> > sortedIndexes = data.GetSortedObjectIndexes(featureIndex);
+    const int* indexes = &sortedIndexes->at(0);
+    data.GatherFeatures(featureIndex, indexes, objectCount, &features[0]);
+    data.GatherTargets(indexes, objectCount, &targets[0]);
+    data.GatherWeights(indexes, objectCount, &weights[0]);
+    // Initializing costs of predicting every label on both sides and for missed values,
+    // they are updated in O(C) when an object crosses the threshold
+    vector<double> belowThresholdCosts(classCount);
+    vector<double> aboveThresholdCosts(classCount);
+    vector<double> missedCosts(classCount);
+    int presentCount = objectCount;
+    while (presentCount > 0 && IsNaN(features[presentCount - 1])) {
+        --presentCount;
+    }
+    for (int objectIndex = 0; objectIndex < objectCount; ++objectIndex) {
+        AddObjectCosts(penalties, classCount, targets[objectIndex], weights[objectIndex],
+                       objectIndex < presentCount ? &aboveThresholdCosts : &missedCosts);
+    }
+    // Choosing best threshold among present values
+    for (int objectIndex = 0; objectIndex < presentCount; ++objectIndex) {
+        double feature = features[objectIndex];
+        AddObjectCosts(penalties, classCount, targets[objectIndex], weights[objectIndex], &belowThresholdCosts);
+        AddObjectCosts(penalties, classCount, targets[objectIndex], -weights[objectIndex], &aboveThresholdCosts);
+        bool isLast = objectIndex + 1 == presentCount;
+        if (!isLast && features[objectIndex + 1] == feature) {
+            // the threshold can't separate equal values
+            continue;
+        }
+        TryThreshold(belowThresholdCosts, aboveThresholdCosts, missedCosts, presentCount < objectCount,
+                     !isLast ? (feature + features[objectIndex + 1]) / 2 : feature + 1.0, split);
+    }
+}
+
+//! Searches the threshold of the feature scanning its bins
+void FindBinnedSplit(const FeatureBinning& binning, int featureIndex,
+                     const vector<int>& targets, const vector<double>& weights,
+                     const vector<double>& penalties, int classCount, Split* split) {
+    vector<double> histogram((MissedBin + 1) * classCount);
+    AccumulateHistogram(binning.GetCodes(featureIndex), &targets[0], &weights[0],
+                        binning.GetObjectCount(), classCount, &histogram[0]);
+    vector<double> belowThresholdCosts(classCount);
+    vector<double> aboveThresholdCosts(classCount);
+    vector<double> missedCosts(classCount);
+    bool hasMissed = false;
+    for (int bin = 0; bin <= MissedBin; ++bin) {
+        for (int target = 0; target < classCount; ++target) {
+            double weight = histogram[bin * classCount + target];
+            if (bin == MissedBin) {
+                AddObjectCosts(penalties, classCount, target, weight, &missedCosts);
+                hasMissed = hasMissed || weight != 0;
+            } else {
+                AddObjectCosts(penalties, classCount, target, weight, &aboveThresholdCosts);
             }
         }
     }
+    for (int bin = 0; bin < binning.GetBinCount(featureIndex); ++bin) {
+        for (int target = 0; target < classCount; ++target) {
+            double weight = histogram[bin * classCount + target];
+            if (weight != 0) {
+                AddObjectCosts(penalties, classCount, target, weight, &belowThresholdCosts);
+                AddObjectCosts(penalties, classCount, target, -weight, &aboveThresholdCosts);
+            }
+        }
+        TryThreshold(belowThresholdCosts, aboveThresholdCosts, missedCosts, hasMissed,
+                     binning.GetThreshold(featureIndex, bin), split);
+    }
+}
+
+//! Gets the class of the greatest sum of object weights
+int GetHeaviestClass(const IDataSet& data) {
+    int objectCount = data.GetObjectCount();
+    vector<int> targets(objectCount);
+    vector<double> weights(objectCount);
+    data.GetTargets(0, objectCount, &targets[0]);
+    data.GetWeights(0, objectCount, &weights[0]);
+    vector<double> classWeights(data.GetClassCount());
+    for (int i = 0; i < objectCount; ++i) {
+        if (targets[i] >= 0 && targets[i] < data.GetClassCount()) {
+            classWeights[targets[i]] += weights[i];
+        }
+    }
+    int heaviestClass = 0;
+    for (int label = 1; label < static_cast<int>(classWeights.size()); ++label) {
+        if (classWeights[label] > classWeights[heaviestClass]) {
+            heaviestClass = label;
+        }
+    }
+    return heaviestClass;
+}
+
+//! Searches thresholds of a range of features (by bins if the binning is given)
+class SplitSearch {
+public:
+    SplitSearch(const IDataSet* data, const FeatureBinning* binning,
+                const vector<int>* targets, const vector<double>* weights,
+                const vector<double>* penalties, vector<Split>* splits)
+        : data_(data),
+          binning_(binning),
+          targets_(targets),
+          weights_(weights),
+          penalties_(penalties),
+          splits_(splits) {
+    }
+
+    void operator() (int first, int last) const {
+        for (int featureIndex = first; featureIndex < last; ++featureIndex) {
+            if (binning_ != NULL) {
+                FindBinnedSplit(*binning_, featureIndex, *targets_, *weights_,
+                                *penalties_, data_->GetClassCount(), &splits_->at(featureIndex));
+            } else {
+                FindSortedSplit(*data_, featureIndex, *penalties_, &splits_->at(featureIndex));
+            }
+        }
+    }
+
+private:
+    const IDataSet* data_;
+    const FeatureBinning* binning_;
+    const vector<int>* targets_;
+    const vector<double>* weights_;
+    const vector<double>* penalties_;
+    vector<Split>* splits_;
+};
+
+void DecisionStump::Learn(IDataSet* data) {
+    int objectCount = data->GetObjectCount();
+    if (objectCount == 0) {
+        return;
+    }
+    // penalties are read from the flat matrix instead of virtual calls
+    vector<double> penalties;
+    GetPenaltyMatrix(data->GetMetaData(), &penalties);
+    const FeatureBinning* binning = NULL;
+    vector<int> targets;
+    vector<double> weights;
+    if (binCount_ > 0) {
+        // features are binned once, then every feature is one pass over its codes
+        binning = &GetBinning(*data);
+        targets.resize(objectCount);
+        weights.resize(objectCount);
+        data->GetTargets(0, objectCount, &targets[0]);
+        data->GetWeights(0, objectCount, &weights[0]);
+    }
+    // features are searched concurrently, the data is only read
+    vector<Split> splits(data->GetFeatureCount());
+    SplitSearch search(data, binning, &targets, &weights, &penalties, &splits);
+    ParallelForThreads(0, data->GetFeatureCount(), search, threadCount_);
+    // with no present values the class of the greatest weight is predicted on both sides
+    separatingFeatureIndex_ = 0;
+    threshold_ = 0;
+    belowThresholdClass_ = aboveThresholdClass_ = GetHeaviestClass(*data);
+    missedBelowThreshold_ = false;
+    // the first feature of the least penalty wins, as if they were searched serially
+    double minPenalty = std::numeric_limits<double>::max();
+    for (int featureIndex = 0; featureIndex < static_cast<int>(splits.size()); ++featureIndex) {
+        const Split& split = splits[featureIndex];
+        if (split.Penalty < minPenalty) {
+            minPenalty = split.Penalty;
+            separatingFeatureIndex_ = featureIndex;
+            belowThresholdClass_ = split.BelowThresholdClass;
+            aboveThresholdClass_ = split.AboveThresholdClass;
+            threshold_ = split.Threshold;
+            missedBelowThreshold_ = split.MissedBelowThreshold;
+        }
+    }
+}
+
+const FeatureBinning& DecisionStump::GetBinning(const IDataSet& data) {
+    // the cached orders are replaced whenever the objects or their values change
+    bool isCached = binningCache_.BinCount == binCount_ &&
+                     static_cast<int>(binningCache_.Orders.size()) == data.GetFeatureCount();
+    for (int featureIndex = 0; isCached && featureIndex < data.GetFeatureCount(); ++featureIndex) {
+        isCached = data.GetSortedObjectIndexes(featureIndex).get() == binningCache_.Orders[featureIndex].get();
+    }
+    if (!isCached) {
+        binningCache_.Binning.Build(data, binCount_, threadCount_, &binningCache_.Orders);
+        binningCache_.BinCount = binCount_;
+    }
+    return binningCache_.Binning;
 }
 
 void DecisionStump::Classify(IDataSet* data) const {
-    for (int i = 0; i < data->GetObjectCount(); ++i) {
-        bool below = data->GetFeature(i, separatingFeatureIndex_) < threshold_;
+    int objectCount = data->GetObjectCount();
+    if (objectCount == 0) {
+        return;
+    }
+    if (belowThresholdClass_ == aboveThresholdClass_) {
+        // the feature doesn't matter (it may not exist if the data had no features)
+        for (int i = 0; i < objectCount; ++i) {
+            data->SetTarget(i, belowThresholdClass_);
+        }
+        return;
+    }
+    vector<double> features(objectCount);
+    data->GetFeatures(separatingFeatureIndex_, 0, objectCount, &features[0]);
+    for (int i = 0; i < objectCount; ++i) {
+        double feature = features[i];
+        bool below = IsNaN(feature) ? missedBelowThreshold_ : feature < threshold_;
         data->SetTarget(i, below ? belowThresholdClass_ : aboveThresholdClass_);
     }
 }
@@ -1,6 +1,7 @@
 #ifndef ROIZNER_DECISION_STUMP_H_
 #define ROIZNER_DECISION_STUMP_H_
 
+#include "binning.h"
 #include "classifier.h"
 #include "factories.h"
 
@@ -8,19 +9,96 @@ namespace mll {
 namespace roizner {
 
 //! Decision-stump classifier
+/*! Features are quantized to bins once per learning and the thresholds are
+    searched by the bins (or by all distinct values when bins are turned off).
+    Missed values are not compared with the threshold: objects with them are
+    sent to the side which gives the least penalty on learning. If no feature
+    has present values, all objects are classified as the class of the
+    greatest weight.
+    Features are searched concurrently on the threads of the global pool, the
+    result doesn't depend on the number of threads.
+    Bins are kept after learning and reused while the data returns the same
+    cached orders of objects, so repeated learning on reweighted data (as in
+    boosting) doesn't bin the features again.
+*/
 class DecisionStump: public Classifier<DecisionStump> {
 	DECLARE_REGISTRATION();
 public:
+    //! Default initialization
+    DecisionStump()
+        : binCount_(MaxBinCount),
+          threadCount_(0),
+          separatingFeatureIndex_(0),
+          threshold_(0),
+          belowThresholdClass_(0),
+          aboveThresholdClass_(0),
+          missedBelowThreshold_(false) {
+        AddParameter("b", binCount_, &DecisionStump::GetBinCount, &DecisionStump::SetBinCount,
+                     "Number of bins of feature values (0 to search all values)");
+        AddParameter("j", threadCount_, &DecisionStump::GetThreadCount, &DecisionStump::SetThreadCount,
+                     "Number of threads of the global pool to search features (0 for all)");
+    }
+
     //! Learn data
     virtual void Learn(IDataSet* data);
     //! Classify data
     virtual void Classify(IDataSet* data) const;
 
+    //! Number of bins of feature values (0 if thresholds are searched by all values)
+    int GetBinCount() const {
+        return binCount_;
+    }
+
+    //! Sets number of bins of feature values
+    void SetBinCount(int binCount) {
+        if (binCount >= 0 && binCount <= MaxBinCount) {
+            binCount_ = binCount;
+        }
+    }
+
+    //! Number of threads of the global pool to search features (0 for all its threads)
+    int GetThreadCount() const {
+        return threadCount_;
+    }
+
+    //! Sets number of threads to search features
+    void SetThreadCount(int threadCount) {
+        if (threadCount >= 0) {
+            threadCount_ = threadCount;
+        }
+    }
+
 private:
+    //! Features binned by the last learning (not copied with the classifier)
+    struct BinningCache {
+        BinningCache()
+            : BinCount(0) {
+        }
+
+        BinningCache(const BinningCache&)
+            : BinCount(0) {
+        }
+
+        BinningCache& operator=(const BinningCache&) {
+            return *this;
+        }
+
+        FeatureBinning Binning;     //!< Binned features
+        int BinCount;               //!< Number of bins they were binned into
+        std::vector< sh_ptr< const std::vector<int> > > Orders; //!< Orders of objects they were built by
+    };
+
+    //! Gets the features binned into binCount_ bins, bins them if the orders of objects changed
+    const FeatureBinning& GetBinning(const IDataSet& data);
+
+    int binCount_;                  //!< Number of bins of feature values (0 for all values)
+    int threadCount_;               //!< Number of threads to search features (0 for all)
     int separatingFeatureIndex_;    //!< Index of separating feature
     double threshold_;              //!< The feature value threshold
     int belowThresholdClass_;       //!< Class label for object below threshold
     int aboveThresholdClass_;       //!< Class label for object above threshold
+    bool missedBelowThreshold_;     //!< If objects with missed values are classified as below threshold
+    BinningCache binningCache_;     //!< Features binned by the last learning
 };
 
 } // namespace roizner
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include "classifier.h"
+#include "dataset.h"
+#include "factories.h"
+#include "thread_pool.h"
+
+using namespace mll;
+
+class DecisionStumpTest : public testing::Test { };
+
+TEST_F(DecisionStumpTest, BinnedSearchTest)
+{
+	const int OBJECTS = 300;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 2);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetFeature(i, 0, (i * 13) % 50);
+		dataSet.SetFeature(i, 1, i % 7 == 0 ? NaN : (i * 11) % 30);
+		dataSet.SetTarget(i, (i * 13) % 50 > 20 || i % 9 == 0);
+		dataSet.SetWeight(i, 1.0 + i % 3);
+	}
+
+	// With fewer distinct values than bins the binned search is exact
+	sh_ptr<IClassifier> binned = ClassifierFactory::Instance().Create("DecisionStump");
+	sh_ptr<IClassifier> sorted = ClassifierFactory::Instance().Create("DecisionStump");
+	ASSERT_TRUE(binned.get() != NULL);
+	ASSERT_TRUE(sorted->SetParameter("b", "0"));
+	binned->Learn(&dataSet);
+	sorted->Learn(&dataSet);
+	DataSetWrapper binnedResults(&dataSet);
+	DataSetWrapper sortedResults(&dataSet);
+	binned->Classify(&binnedResults);
+	sorted->Classify(&sortedResults);
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(sortedResults.GetTarget(i), binnedResults.GetTarget(i));
+	}
+}
+
+TEST_F(DecisionStumpTest, ParallelSearchTest)
+{
+	const int OBJECTS = 200;
+	const int FEATURES = 40;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, FEATURES);
+	for (int i = 0; i < OBJECTS; i++) {
+		dataSet.SetTarget(i, i % 2);
+		dataSet.SetWeight(i, 1.0);
+		for (int j = 0; j < FEATURES; j++) {
+			// features 9, 19, 29 and 39 separate the classes equally well
+			dataSet.SetFeature(i, j, j % 10 == 9 ? i % 2 * (j + 1) : (i * (j + 3)) % 17);
+		}
+	}
+	// the first of the equal features must be chosen, it's inverted in the test set
+	DataSetWrapper testSet(&dataSet);
+	for (int i = 0; i < OBJECTS; i++) {
+		testSet.SetFeature(i, 9, (1 - i % 2) * 10);
+	}
+
+	ThreadPool::SetGlobalThreadCount(4);
+	const char* bins[] = { "0", "8", "255" };
+	for (int b = 0; b < 3; b++) {
+		sh_ptr<IClassifier> serial = ClassifierFactory::Instance().Create("DecisionStump");
+		sh_ptr<IClassifier> parallel = ClassifierFactory::Instance().Create("DecisionStump");
+		ASSERT_TRUE(serial->SetParameter("b", bins[b]));
+		ASSERT_TRUE(parallel->SetParameter("b", bins[b]));
+		ASSERT_TRUE(serial->SetParameter("j", "1"));
+		ASSERT_TRUE(parallel->SetParameter("j", "0"));
+		serial->Learn(&dataSet);
+		parallel->Learn(&dataSet);
+		DataSetWrapper serialResults(&testSet);
+		DataSetWrapper parallelResults(&testSet);
+		serial->Classify(&serialResults);
+		parallel->Classify(&parallelResults);
+		for (int i = 0; i < OBJECTS; i++) {
+			ASSERT_EQ(1 - i % 2, serialResults.GetTarget(i));
+			ASSERT_EQ(1 - i % 2, parallelResults.GetTarget(i));
+		}
+	}
+	ThreadPool::SetGlobalThreadCount(0);
+}
+
+TEST_F(DecisionStumpTest, MissedValuesTest)
+{
+	const int OBJECTS = 100;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 1);
+	for (int i = 0; i < OBJECTS; i++) {
+		// objects with missed values belong to the class of the small values
+		dataSet.SetFeature(i, 0, i % 2 == 1 ? NaN : i % 4);
+		dataSet.SetTarget(i, i % 4 == 2);
+		dataSet.SetWeight(i, 1.0);
+	}
+
+	const char* bins[] = { "0", "255" };
+	for (int b = 0; b < 2; b++) {
+		sh_ptr<IClassifier> stump = ClassifierFactory::Instance().Create("DecisionStump");
+		ASSERT_TRUE(stump->SetParameter("b", bins[b]));
+		stump->Learn(&dataSet);
+		DataSetWrapper results(&dataSet);
+		stump->Classify(&results);
+		for (int i = 0; i < OBJECTS; i++) {
+			ASSERT_EQ(i % 4 == 2, results.GetTarget(i));
+		}
+	}
+}
+
+TEST_F(DecisionStumpTest, AllMissedTest)
+{
+	const int OBJECTS = 30;
+
+	std::vector<std::string> classes;
+	classes.push_back("0");
+	classes.push_back("1");
+	DataSet dataSet;
+	dataSet.GetMetaData().SetTargetNominalValues(classes);
+	dataSet.Resize(OBJECTS, 1);
+	for (int i = 0; i < OBJECTS; i++) {
+		// the only feature is missed, the class 1 is heavier though rarer
+		dataSet.SetFeature(i, 0, NaN);
+		dataSet.SetTarget(i, i % 3 == 0);
+		dataSet.SetWeight(i, i % 3 == 0 ? 3.0 : 1.0);
+	}
+
+	const char* bins[] = { "0", "255" };
+	for (int b = 0; b < 2; b++) {
+		sh_ptr<IClassifier> stump = ClassifierFactory::Instance().Create("DecisionStump");
+		ASSERT_TRUE(stump->SetParameter("b", bins[b]));
+		stump->Learn(&dataSet);
+		DataSetWrapper results(&dataSet);
+		stump->Classify(&results);
+		for (int i = 0; i < OBJECTS; i++) {
+			ASSERT_EQ(1, results.GetTarget(i));
+		}
+	}
+
+	// with no features at all the heaviest class is predicted too
+	DataSetWrapper noFeatures(&dataSet);
+	std::vector<int> featureIndexes;
+	noFeatures.SetFeatureIndexes(featureIndexes.begin(), featureIndexes.end());
+	sh_ptr<IClassifier> stump = ClassifierFactory::Instance().Create("DecisionStump");
+	stump->Learn(&noFeatures);
+	DataSetWrapper results(&noFeatures);
+	stump->Classify(&results);
+	for (int i = 0; i < OBJECTS; i++) {
+		ASSERT_EQ(1, results.GetTarget(i));
+	}
+}